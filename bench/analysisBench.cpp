@@ -0,0 +1,48 @@
+// Скорость криптоанализа шифра Гронсфельда.
+// Использование: analysis_bench [букв=1048576] [макс. период=200] [потоков=0]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <locale>
+#include <random>
+#include <string>
+#include "../task1/gronsfeldAnalysis.h"
+#include "../task1/modAlphaCipher.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    locale::global(locale("ru_RU.UTF-8"));
+    size_t length = argc > 1 ? strtoull(argv[1], nullptr, 10) : (1 << 20);
+    int maxPeriod = argc > 2 ? atoi(argv[2]) : 200;
+    unsigned threads = argc > 3 ? static_cast<unsigned>(atoi(argv[3])) : 0;
+
+    mt19937 rng(7);
+    discrete_distribution<int> pick(begin(russianFrequencies), end(russianFrequencies));
+    wstring text(length, L'А');
+    for (auto& c : text) {
+        c = modAlphaCipher::alphabet()[pick(rng)];
+    }
+    const wstring key = L"КЛЮЧДЛЯПРОВЕРКИСТОЙКОСТИ";
+    wstring encrypted = modAlphaCipher(key).encrypt(text);
+
+    auto t0 = chrono::steady_clock::now();
+    gronsfeldAnalyzer analyzer(encrypted, threads);
+    double load = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    t0 = chrono::steady_clock::now();
+    vector<periodScore> scores = analyzer.scorePeriods(maxPeriod);
+    double score = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    t0 = chrono::steady_clock::now();
+    gronsfeldAudit report = analyzer.audit(maxPeriod);
+    double total = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    printf("букв: %zu, периоды 1-%d\n", analyzer.size(), maxPeriod);
+    printf("%8.1f мс  перевод текста\n", load * 1000);
+    printf("%8.1f мс  индекс совпадений и хи-квадрат по всем периодам\n", score * 1000);
+    printf("%8.1f мс  полный аудит (период + ключ)\n", total * 1000);
+    printf("период %d, хи-квадрат %.1f, ключ %s\n", report.period, report.chiSquared,
+           report.key == key ? "восстановлен" : "НЕ восстановлен");
+    return report.key == key ? 0 : 1;
+}
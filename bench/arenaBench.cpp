@@ -0,0 +1,77 @@
+// Пропускная способность шифров на нескольких потоках: временные буферы
+// из общей кучи против арены запроса (monotonic_buffer_resource на буфере
+// потока, освобождается целиком после каждого запроса).
+// Использование: arena_bench [запросов на поток=20000] [максимум потоков=по числу ядер]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <locale>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../task1/modAlphaCipher.h"
+#include "../task2/routeCipher.h"
+
+using namespace std;
+
+static const wstring request = L"Шифр маршрутной перестановки и шифр Гронсфельда обрабатывают "
+                               L"короткие запросы сервиса: каждый запрос - одна строка текста";
+
+// Запрос: зашифровать и расшифровать обоими шифрами
+template <class Body>
+static double run(unsigned threads, size_t requests, Body body) {
+    auto t0 = chrono::steady_clock::now();
+    vector<thread> pool;
+    for (unsigned t = 0; t < threads; t++) {
+        pool.emplace_back([&]() {
+            for (size_t i = 0; i < requests; i++) {
+                body();
+            }
+        });
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+    double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    return threads * requests / sec;
+}
+
+int main(int argc, char** argv) {
+    locale::global(locale("ru_RU.UTF-8"));
+    size_t requests = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000;
+    unsigned maxThreads = argc > 2 ? atoi(argv[2]) : thread::hardware_concurrency();
+    if (maxThreads == 0) {
+        maxThreads = 1;
+    }
+
+    const modAlphaCipher gronsfeld(L"КЛЮЧ");
+    const routeCipher route(8);
+    if (gronsfeld.encrypt(request) != gronsfeld.encrypt(request, pmr::get_default_resource()).c_str() ||
+        route.encrypt(request) != route.encrypt(request, pmr::get_default_resource()).c_str()) {
+        printf("результаты с ареной и без РАЗЛИЧАЮТСЯ\n");
+        return 1;
+    }
+
+    printf("запросов на поток: %zu, длина запроса: %zu символов\n", requests, request.size());
+    printf("потоков      куча, зап/с     арена, зап/с  выигрыш\n");
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        double heap = run(threads, requests, [&]() {
+            wstring g = gronsfeld.decrypt(gronsfeld.encrypt(request));
+            wstring r = route.decrypt(route.encrypt(request));
+            return g.size() + r.size();
+        });
+        double arena = run(threads, requests, [&]() {
+            thread_local vector<char> buffer(64 * 1024);
+            pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size());
+            pmr::wstring g = gronsfeld.decrypt(gronsfeld.encrypt(request, &resource), &resource);
+            pmr::wstring r = route.decrypt(route.encrypt(request, &resource), &resource);
+            return g.size() + r.size();
+        });
+        printf("%7u %16.0f %16.0f %7.2fx\n", threads, heap, arena, arena / heap);
+        if (threads < maxThreads && threads * 2 > maxThreads) {
+            threads = maxThreads / 2; // последняя строка - ровно maxThreads
+        }
+    }
+    return 0;
+}
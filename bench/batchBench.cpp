@@ -0,0 +1,57 @@
+// Пакетное шифрование routeCipher против цикла одиночных вызовов.
+// Использование: batch_bench [записей=100000] [длина записи=128] [столбцов=8]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <locale>
+#include <random>
+#include <string>
+#include "../task2/routeBatch.h"
+#include "../task2/routeCipher.h"
+
+using namespace std;
+
+static double seconds_since(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    locale::global(locale("ru_RU.UTF-8"));
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 100000;
+    int length = argc > 2 ? atoi(argv[2]) : 128;
+    int columns = argc > 3 ? atoi(argv[3]) : 8;
+
+    const wstring alphabet = L"АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ";
+    mt19937 rng(1);
+    wstring records(count * length, L'А');
+    for (auto& c : records) {
+        c = alphabet[rng() % alphabet.size()];
+    }
+
+    routeCipher cipher(columns);
+    auto t0 = chrono::steady_clock::now();
+    wstring single;
+    single.reserve(records.size());
+    for (size_t r = 0; r < count; r++) {
+        single += cipher.encrypt(records.substr(r * length, length));
+    }
+    double loop = seconds_since(t0);
+
+    routeBatch batch(columns, length);
+    t0 = chrono::steady_clock::now();
+    wstring checked = batch.encrypt(records);
+    double arena = seconds_since(t0);
+
+    wstring raw(records.size(), L' ');
+    t0 = chrono::steady_clock::now();
+    batch.encrypt(records.data(), &raw[0], count);
+    double gather = seconds_since(t0);
+
+    printf("записей: %zu по %d букв, столбцов: %d\n", count, length, columns);
+    printf("%12.0f записей/с  цикл routeCipher::encrypt\n", count / loop);
+    printf("%12.0f записей/с  routeBatch::encrypt(wstring), с проверкой\n", count / arena);
+    printf("%12.0f записей/с  routeBatch::encrypt(буферы), без проверки\n", count / gather);
+    bool same = single == checked && checked == raw;
+    printf("результаты %s\n", same ? "совпадают" : "РАЗЛИЧАЮТСЯ");
+    return same ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+// Пропускная способность контейнера шифротекста.
+// Использование: container_bench [мегабайт=1024] [файл=/tmp/cipher_container.bin] [потоков=0]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <locale>
+#include <random>
+#include <string>
+#include <thread>
+#include "../common/cipherContainer.h"
+
+using namespace std;
+
+static double seconds_since(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+}
+
+static void report(const char* stage, uint64_t bytes, double sec) {
+    printf("%8.2f с  %9.1f МБ/с  %s\n", sec, bytes / sec / (1 << 20), stage);
+}
+
+static void run(const char* name, const containerCipher& c, uint64_t megabytes,
+                const string& path, unsigned threads) {
+    const wstring alphabet = L"АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ";
+    // Кириллица занимает 2 байта в UTF-8
+    uint64_t letters = megabytes * (1 << 20) / 2;
+    const size_t piece = 1 << 20;
+    mt19937 rng(42);
+    wstring text(piece, L'А');
+
+    printf("\n=== %s, %llu МБ, потоков: %u ===\n", name,
+           static_cast<unsigned long long>(megabytes), threads);
+
+    auto t0 = chrono::steady_clock::now();
+    {
+        fstream out(path, ios::out | ios::binary | ios::trunc);
+        cipherContainerWriter writer(out, c, 65536, threads);
+        for (uint64_t done = 0; done < letters; done += piece) {
+            size_t n = static_cast<size_t>(min<uint64_t>(piece, letters - done));
+            for (size_t i = 0; i < n; i++) {
+                text[i] = alphabet[rng() % alphabet.size()];
+            }
+            writer.write(n == piece ? text : text.substr(0, n));
+        }
+        writer.finish();
+    }
+    report("запись", letters * 2, seconds_since(t0));
+
+    ifstream in(path, ios::binary);
+    cipherContainerReader reader(in);
+
+    t0 = chrono::steady_clock::now();
+    bool ok = reader.verify(threads);
+    report(ok ? "проверка CRC" : "проверка CRC (ОШИБКА)", letters * 2, seconds_since(t0));
+
+    t0 = chrono::steady_clock::now();
+    reader.decryptAll(c, [](size_t, const wstring&) {}, 1);
+    report("расшифрование, 1 поток", letters * 2, seconds_since(t0));
+
+    t0 = chrono::steady_clock::now();
+    reader.decryptAll(c, [](size_t, const wstring&) {}, threads);
+    report("расшифрование, все потоки", letters * 2, seconds_since(t0));
+
+    t0 = chrono::steady_clock::now();
+    size_t chunks = reader.getChunkCount();
+    for (size_t i = 0; i < 64 && chunks; i++) {
+        reader.decryptChunk((i * 7919) % chunks, c);
+    }
+    printf("%8.2f мс               %s\n", seconds_since(t0) * 1000, "64 случайных блока");
+}
+
+int main(int argc, char** argv) {
+    locale::global(locale("ru_RU.UTF-8"));
+    uint64_t megabytes = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1024;
+    string path = argc > 2 ? argv[2] : "/tmp/cipher_container.bin";
+    unsigned threads = argc > 3 ? static_cast<unsigned>(atoi(argv[3])) : thread::hardware_concurrency();
+    if (threads == 0) {
+        threads = 1;
+    }
+
+    run("modAlphaCipher", containerCipher::gronsfeld(L"КЛЮЧШИФРА"), megabytes, path, threads);
+    run("routeCipher", containerCipher::route(16), megabytes, path, threads);
+    remove(path.c_str());
+    return 0;
+}
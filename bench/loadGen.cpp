@@ -0,0 +1,108 @@
+// Нагрузка на запущенный cipherd: задержка p50/p99 и запросов в секунду.
+// Каждое соединение - отдельный поток, держит depth неотвеченных запросов.
+// Использование: load_gen [сокет=/tmp/cipherd.sock] [соединений=8] [запросов на соединение=5000] [depth=1]
+#include <algorithm>
+#include <chrono>
+#include <codecvt>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <locale>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../daemon/cipherProtocol.h"
+
+using namespace std;
+
+typedef chrono::steady_clock clock_type;
+
+static string utf8(const wstring& ws) {
+    wstring_convert<codecvt_utf8<wchar_t>, wchar_t> codec;
+    return codec.to_bytes(ws);
+}
+
+// Смесь запросов: четыре ключа Гронсфельда и три ширины маршрута
+static cipherRequest make_request(uint32_t id, const string& text) {
+    static const wstring keys[] = {L"КЛЮЧ", L"ШИФР", L"ДЕМОН", L"ПАКЕТ"};
+    static const uint32_t widths[] = {4, 8, 16};
+    cipherRequest r;
+    r.id = id;
+    r.op = cipherOp::encrypt;
+    r.text = text;
+    if (id % 7 < 4) {
+        r.kind = cipherKind::gronsfeld;
+        r.key = utf8(keys[id % 7]);
+    } else {
+        r.kind = cipherKind::route;
+        r.columns = widths[id % 7 - 4];
+    }
+    return r;
+}
+
+int main(int argc, char** argv) {
+    locale::global(locale("ru_RU.UTF-8"));
+    string path = argc > 1 ? argv[1] : "/tmp/cipherd.sock";
+    unsigned connections = argc > 2 ? atoi(argv[2]) : 8;
+    size_t requests = argc > 3 ? strtoull(argv[3], nullptr, 10) : 5000;
+    size_t depth = argc > 4 ? strtoull(argv[4], nullptr, 10) : 1;
+    if (connections == 0 || requests == 0 || depth == 0) {
+        fprintf(stderr, "load_gen: параметры должны быть положительными\n");
+        return 1;
+    }
+    const string text = utf8(L"Локальный демон шифрования принимает запросы через сокет");
+
+    vector<vector<double>> latencies(connections);
+    vector<size_t> errors(connections, 0);
+    vector<string> failures(connections);
+    auto t0 = clock_type::now();
+    vector<thread> pool;
+    for (unsigned c = 0; c < connections; c++) {
+        pool.emplace_back([&, c]() {
+            try {
+                cipherClient client(path);
+                vector<clock_type::time_point> sent(requests);
+                latencies[c].reserve(requests);
+                size_t next = 0;
+                for (size_t received = 0; received < requests; received++) {
+                    while (next < requests && next - received < depth) {
+                        sent[next] = clock_type::now();
+                        client.send(make_request(next, text));
+                        next++;
+                    }
+                    cipherReply r = client.receive();
+                    auto latency = clock_type::now() - sent[r.id];
+                    latencies[c].push_back(chrono::duration<double, micro>(latency).count());
+                    errors[c] += r.status != replyStatus::ok;
+                }
+            } catch (const exception& e) {
+                failures[c] = e.what();
+            }
+        });
+    }
+    for (auto& t : pool) {
+        t.join();
+    }
+    double sec = chrono::duration<double>(clock_type::now() - t0).count();
+
+    vector<double> all;
+    size_t errorCount = 0;
+    for (unsigned c = 0; c < connections; c++) {
+        if (!failures[c].empty()) {
+            fprintf(stderr, "load_gen: соединение %u: %s\n", c, failures[c].c_str());
+            return 1;
+        }
+        all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+        errorCount += errors[c];
+    }
+    sort(all.begin(), all.end());
+    auto percentile = [&all](double p) { return all[min(all.size() - 1, size_t(p * all.size()))]; };
+
+    printf("соединений: %u, запросов на соединение: %zu, depth: %zu\n", connections, requests, depth);
+    printf("%12.0f запросов/с\n", all.size() / sec);
+    printf("%12.1f мкс  p50\n", percentile(0.50));
+    printf("%12.1f мкс  p99\n", percentile(0.99));
+    printf("%12.1f мкс  максимум\n", all.back());
+    printf("ошибок: %zu\n", errorCount);
+    return errorCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+// Скорость отклонения некорректных входных данных:
+// API с исключениями против tryEncrypt/tryDecrypt.
+// Использование: reject_bench [итераций=1000000]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <locale>
+#include <string>
+#include <vector>
+#include "../task1/modAlphaCipher.h"
+#include "../task2/routeCipher.h"
+
+using namespace std;
+
+// Типичный брак: цифра, строчная буква или знак внутри шифротекста
+static vector<wstring> malformed() {
+    vector<wstring> v;
+    const wstring base = L"ЭТООЧЕНЬДЛИННЫЙШИФРОТЕКСТДЛЯПРОВЕРКИСКОРОСТИОТКЛОНЕНИЯ";
+    const wchar_t bad[] = {L'7', L'ж', L'!', L' '};
+    for (size_t i = 0; i < 64; i++) {
+        wstring s = base;
+        s[(i * 13) % s.size()] = bad[i % 4];
+        v.push_back(s);
+    }
+    v.push_back(L"");
+    return v;
+}
+
+template <class Body>
+static void measure(const char* name, size_t iterations, Body body) {
+    auto t0 = chrono::steady_clock::now();
+    size_t rejected = 0;
+    for (size_t i = 0; i < iterations; i++) {
+        rejected += body(i);
+    }
+    double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    printf("%12.0f отклонений/с  %6.1f нс/вызов  %s%s\n", rejected / sec, sec * 1e9 / iterations,
+           name, rejected == iterations ? "" : " (ОШИБКА: принят некорректный вход)");
+}
+
+int main(int argc, char** argv) {
+    locale::global(locale("ru_RU.UTF-8"));
+    size_t iterations = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    const vector<wstring> inputs = malformed();
+    const size_t n = inputs.size();
+
+    modAlphaCipher gronsfeld(L"КЛЮЧ");
+    routeCipher route(8);
+
+    printf("=== modAlphaCipher::decrypt, %zu вызовов ===\n", iterations);
+    measure("исключения", iterations, [&](size_t i) -> size_t {
+        try {
+            gronsfeld.decrypt(inputs[i % n]);
+            return 0;
+        } catch (const cipher_error&) {
+            return 1;
+        }
+    });
+    measure("tryDecrypt", iterations, [&](size_t i) -> size_t {
+        return gronsfeld.tryDecrypt(inputs[i % n]) ? 0 : 1;
+    });
+
+    printf("\n=== routeCipher::decrypt, %zu вызовов ===\n", iterations);
+    measure("исключения", iterations, [&](size_t i) -> size_t {
+        try {
+            route.decrypt(inputs[i % n]);
+            return 0;
+        } catch (const route_cipher_error&) {
+            return 1;
+        }
+    });
+    measure("tryDecrypt", iterations, [&](size_t i) -> size_t {
+        return route.tryDecrypt(inputs[i % n]) ? 0 : 1;
+    });
+
+    const wstring noLetters = L"1234567890 !@#$%^&*() 1234567890";
+    printf("\n=== encrypt текста без букв, %zu вызовов ===\n", iterations);
+    measure("modAlphaCipher: исключения", iterations, [&](size_t) -> size_t {
+        try {
+            gronsfeld.encrypt(noLetters);
+            return 0;
+        } catch (const cipher_error&) {
+            return 1;
+        }
+    });
+    measure("modAlphaCipher: tryEncrypt", iterations, [&](size_t) -> size_t {
+        return gronsfeld.tryEncrypt(noLetters) ? 0 : 1;
+    });
+    measure("routeCipher: исключения", iterations, [&](size_t) -> size_t {
+        try {
+            route.encrypt(noLetters);
+            return 0;
+        } catch (const route_cipher_error&) {
+            return 1;
+        }
+    });
+    measure("routeCipher: tryEncrypt", iterations, [&](size_t) -> size_t {
+        return route.tryEncrypt(noLetters) ? 0 : 1;
+    });
+    return 0;
+}
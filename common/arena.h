@@ -0,0 +1,16 @@
+#pragma once
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// Временные контейнеры шифров берут распределитель памяти у строки результата:
+// для std::wstring это обычная куча, для std::pmr::wstring - ее memory_resource
+// (например, monotonic_buffer_resource одного запроса, освобождаемый целиком).
+
+template <class String, class T>
+using reboundAllocator = typename std::allocator_traits<typename String::allocator_type>::template rebind_alloc<T>;
+
+// vector<T> с тем же распределителем, что у String
+template <class String, class T>
+using arenaVector = std::vector<T, reboundAllocator<String, T>>;
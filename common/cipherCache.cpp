@@ -0,0 +1,37 @@
+#include "cipherCache.h"
+
+cipherCache::cipherCache(size_t capacity):
+    gronsfeldCache(capacity), routeCache(capacity)
+{
+}
+
+std::shared_ptr<const modAlphaCipher> cipherCache::gronsfeld(const std::wstring& key)
+{
+    return gronsfeldCache.get(key, [&key]() {
+        return std::make_shared<const modAlphaCipher>(key);
+    });
+}
+
+std::shared_ptr<const routeCipher> cipherCache::route(int columns)
+{
+    return routeCache.get(columns, [columns]() {
+        return std::make_shared<const routeCipher>(columns);
+    });
+}
+
+cacheStats cipherCache::stats() const
+{
+    cacheStats a = gronsfeldCache.stats();
+    cacheStats b = routeCache.stats();
+    a.hits += b.hits;
+    a.misses += b.misses;
+    a.evictions += b.evictions;
+    a.size += b.size;
+    return a;
+}
+
+void cipherCache::clear()
+{
+    gronsfeldCache.clear();
+    routeCache.clear();
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include "../task1/modAlphaCipher.h"
+#include "../task2/routeCipher.h"
+
+// Счетчики кэша
+struct cacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t size = 0;
+};
+
+// Потокобезопасный LRU-кэш неизменяемых объектов.
+// Объект строится вне блокировки, поэтому медленный конструктор одного ключа
+// не задерживает попадания по другим; если два потока одновременно промахнулись
+// по одному ключу, в кэше остается объект того, кто вставил первым.
+template <class Key, class Value>
+class lruCache
+{
+private:
+    typedef std::pair<Key, std::shared_ptr<const Value>> entry;
+    size_t capacity;
+    std::list<entry> order; // начало списка - самый свежий
+    std::unordered_map<Key, typename std::list<entry>::iterator> items;
+    cacheStats counters;
+    mutable std::mutex lock;
+
+public:
+    explicit lruCache(size_t cap) : capacity(cap == 0 ? 1 : cap) {}
+
+    template <class Factory>
+    std::shared_ptr<const Value> get(const Key& key, Factory make)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            auto it = items.find(key);
+            if (it != items.end()) {
+                counters.hits++;
+                order.splice(order.begin(), order, it->second);
+                return it->second->second;
+            }
+            counters.misses++;
+        }
+
+        std::shared_ptr<const Value> value = make(); // исключение не попадает в кэш
+
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = items.find(key);
+        if (it != items.end()) {
+            order.splice(order.begin(), order, it->second);
+            return it->second->second;
+        }
+        order.emplace_front(key, value);
+        items[key] = order.begin();
+        if (order.size() > capacity) {
+            items.erase(order.back().first);
+            order.pop_back();
+            counters.evictions++;
+        }
+        return value;
+    }
+
+    cacheStats stats() const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        cacheStats s = counters;
+        s.size = order.size();
+        return s;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        items.clear();
+        order.clear();
+    }
+};
+
+// Кэш подготовленных шифров: ключ modAlphaCipher хранится по тексту ключа,
+// routeCipher - по числу столбцов. Возвращаемые объекты неизменяемы
+// и остаются валидными после вытеснения из кэша.
+class cipherCache
+{
+private:
+    lruCache<std::wstring, modAlphaCipher> gronsfeldCache;
+    lruCache<int, routeCipher> routeCache;
+
+public:
+    explicit cipherCache(size_t capacity = 64);
+
+    std::shared_ptr<const modAlphaCipher> gronsfeld(const std::wstring& key);
+    std::shared_ptr<const routeCipher> route(int columns);
+
+    cacheStats gronsfeldStats() const { return gronsfeldCache.stats(); }
+    cacheStats routeStats() const { return routeCache.stats(); }
+    cacheStats stats() const; // сумма по обоим шифрам
+    void clear();
+};
@@ -0,0 +1,446 @@
+#include "cipherContainer.h"
+#include "parallel.h"
+#include "../task1/modAlphaCipher.h"
+#include "../task2/routeCipher.h"
+#include <algorithm>
+#include <cstring>
+#include <cwctype>
+#include <istream>
+#include <ostream>
+
+namespace {
+
+const char magic[4] = {'G', 'R', 'C', 'C'};
+const uint16_t version = 1;
+const size_t headerSize = 48;
+const size_t indexEntrySize = 20;
+
+uint32_t crc32(const char* data, size_t size, uint32_t crc = 0)
+{
+	static const std::vector<uint32_t> table = []() {
+		std::vector<uint32_t> t(256);
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++) {
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			}
+			t[i] = c;
+		}
+		return t;
+	}();
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++) {
+		crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+uint32_t crc32(const std::string& s)
+{
+	return crc32(s.data(), s.size());
+}
+
+void putU16(std::string& out, uint16_t v)
+{
+	out.push_back(static_cast<char>(v & 0xFF));
+	out.push_back(static_cast<char>(v >> 8));
+}
+
+void putU32(std::string& out, uint32_t v)
+{
+	for (int i = 0; i < 4; i++) {
+		out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+	}
+}
+
+void putU64(std::string& out, uint64_t v)
+{
+	for (int i = 0; i < 8; i++) {
+		out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+	}
+}
+
+uint32_t getU32(const char* p)
+{
+	uint32_t v = 0;
+	for (int i = 3; i >= 0; i--) {
+		v = (v << 8) | static_cast<unsigned char>(p[i]);
+	}
+	return v;
+}
+
+uint64_t getU64(const char* p)
+{
+	uint64_t v = 0;
+	for (int i = 7; i >= 0; i--) {
+		v = (v << 8) | static_cast<unsigned char>(p[i]);
+	}
+	return v;
+}
+
+std::string toUtf8(const std::wstring& ws)
+{
+	std::string out;
+	out.reserve(ws.size() * 2);
+	for (wchar_t wc : ws) {
+		uint32_t c = static_cast<uint32_t>(wc);
+		if (c < 0x80) {
+			out.push_back(static_cast<char>(c));
+		} else if (c < 0x800) {
+			out.push_back(static_cast<char>(0xC0 | (c >> 6)));
+			out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+		} else if (c < 0x10000) {
+			out.push_back(static_cast<char>(0xE0 | (c >> 12)));
+			out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+			out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+		} else {
+			out.push_back(static_cast<char>(0xF0 | (c >> 18)));
+			out.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+			out.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+			out.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+		}
+	}
+	return out;
+}
+
+std::wstring fromUtf8(const std::string& s)
+{
+	std::wstring out;
+	out.reserve(s.size() / 2);
+	size_t i = 0;
+	while (i < s.size()) {
+		unsigned char b = s[i];
+		uint32_t c;
+		size_t extra;
+		if (b < 0x80) {
+			c = b;
+			extra = 0;
+		} else if ((b & 0xE0) == 0xC0) {
+			c = b & 0x1F;
+			extra = 1;
+		} else if ((b & 0xF0) == 0xE0) {
+			c = b & 0x0F;
+			extra = 2;
+		} else if ((b & 0xF8) == 0xF0) {
+			c = b & 0x07;
+			extra = 3;
+		} else {
+			throw container_error("Invalid UTF-8 in chunk");
+		}
+		if (i + extra >= s.size()) {
+			throw container_error("Truncated UTF-8 in chunk");
+		}
+		for (size_t k = 1; k <= extra; k++) {
+			unsigned char cont = s[i + k];
+			if ((cont & 0xC0) != 0x80) {
+				throw container_error("Invalid UTF-8 in chunk");
+			}
+			c = (c << 6) | (cont & 0x3F);
+		}
+		out.push_back(static_cast<wchar_t>(c));
+		i += extra + 1;
+	}
+	return out;
+}
+
+std::wstring encryptText(const containerCipher& c, const std::wstring& text)
+{
+	if (c.kind == cipherKind::gronsfeld) {
+		modAlphaCipher cipher(c.key);
+		return cipher.encrypt(text);
+	}
+	routeCipher cipher(c.columns);
+	return cipher.encrypt(text);
+}
+
+std::wstring decryptText(const containerCipher& c, const std::wstring& text)
+{
+	if (c.kind == cipherKind::gronsfeld) {
+		modAlphaCipher cipher(c.key);
+		return cipher.decrypt(text);
+	}
+	routeCipher cipher(c.columns);
+	return cipher.decrypt(text);
+}
+
+}
+
+containerCipher containerCipher::gronsfeld(const std::wstring& key)
+{
+	containerCipher c;
+	c.kind = cipherKind::gronsfeld;
+	c.key = key;
+	c.columns = 0;
+	return c;
+}
+
+containerCipher containerCipher::route(int columns)
+{
+	containerCipher c;
+	c.kind = cipherKind::route;
+	c.columns = columns;
+	return c;
+}
+
+uint32_t containerCipher::check() const
+{
+	std::string bytes(1, static_cast<char>(kind));
+	if (kind == cipherKind::gronsfeld) {
+		std::wstring upper(key);
+		for (auto& ch : upper) {
+			ch = towupper(ch);
+		}
+		bytes += toUtf8(upper);
+	} else {
+		putU32(bytes, static_cast<uint32_t>(columns));
+	}
+	return crc32(bytes);
+}
+
+// =========== ЗАПИСЬ ===========
+
+cipherContainerWriter::cipherContainerWriter(std::ostream& os, const containerCipher& c,
+                                             uint32_t chunk_letters, unsigned thread_count):
+	out(os), cipher(c), chunkLetters(chunk_letters),
+	threads(resolveThreads(thread_count, static_cast<size_t>(-1)))
+{
+	if (chunkLetters == 0)
+		throw container_error("Chunk size must be positive");
+	encryptText(cipher, L"А"); // проверка ключа до записи чего-либо
+	std::streampos pos = out.tellp();
+	if (pos == std::streampos(-1))
+		throw container_error("Output stream is not seekable");
+	start = static_cast<uint64_t>(pos);
+	out.write(std::string(headerSize, '\0').data(), headerSize);
+	if (!out)
+		throw container_error("Write error");
+}
+
+void cipherContainerWriter::write(const std::wstring& open_text)
+{
+	if (finished)
+		throw container_error("Container is already finished");
+	for (auto c : open_text) {
+		if (iswalpha(c)) {
+			pending.push_back(towupper(c));
+		}
+	}
+	// Копим несколько блоков на поток, чтобы шифровать их пачкой
+	size_t batch = static_cast<size_t>(chunkLetters) * threads * 2;
+	if (pending.size() >= batch) {
+		flushChunks(pending.size() / chunkLetters * chunkLetters);
+	}
+}
+
+void cipherContainerWriter::flushChunks(size_t letters)
+{
+	size_t count = (letters + chunkLetters - 1) / chunkLetters;
+	std::vector<std::string> payloads(count);
+	std::vector<containerChunk> chunks(count);
+	parallelFor(count, threads, [&](size_t i) {
+		size_t from = i * chunkLetters;
+		size_t len = std::min<size_t>(chunkLetters, letters - from);
+		payloads[i] = toUtf8(encryptText(cipher, pending.substr(from, len)));
+		chunks[i].size = static_cast<uint32_t>(payloads[i].size());
+		chunks[i].letters = static_cast<uint32_t>(len);
+		chunks[i].crc = crc32(payloads[i]);
+	});
+
+	uint64_t offset = index.empty() ? headerSize : index.back().offset + index.back().size;
+	for (size_t i = 0; i < count; i++) {
+		chunks[i].offset = offset;
+		offset += chunks[i].size;
+		out.write(payloads[i].data(), payloads[i].size());
+		index.push_back(chunks[i]);
+	}
+	if (!out)
+		throw container_error("Write error");
+	pending.erase(0, letters);
+	totalLetters += letters;
+}
+
+void cipherContainerWriter::finish()
+{
+	if (finished)
+		return;
+	if (!pending.empty()) {
+		flushChunks(pending.size());
+	}
+
+	uint64_t indexOffset = index.empty() ? headerSize : index.back().offset + index.back().size;
+	std::string indexBytes;
+	indexBytes.reserve(index.size() * indexEntrySize);
+	for (const auto& ch : index) {
+		putU64(indexBytes, ch.offset);
+		putU32(indexBytes, ch.size);
+		putU32(indexBytes, ch.letters);
+		putU32(indexBytes, ch.crc);
+	}
+	out.write(indexBytes.data(), indexBytes.size());
+	std::streampos end = out.tellp();
+
+	std::string header(magic, sizeof(magic));
+	putU16(header, version);
+	header.push_back(static_cast<char>(cipher.kind));
+	header.push_back('\0');
+	putU32(header, chunkLetters);
+	putU32(header, cipher.check());
+	putU64(header, index.size());
+	putU64(header, totalLetters);
+	putU64(header, indexOffset);
+	putU32(header, crc32(indexBytes));
+	putU32(header, crc32(header));
+
+	out.seekp(static_cast<std::streamoff>(start));
+	out.write(header.data(), header.size());
+	out.seekp(end);
+	out.flush();
+	if (!out)
+		throw container_error("Write error");
+	finished = true;
+}
+
+// =========== ЧТЕНИЕ ===========
+
+cipherContainerReader::cipherContainerReader(std::istream& is):
+	in(is)
+{
+	std::streampos pos = in.tellg();
+	if (pos == std::streampos(-1))
+		throw container_error("Input stream is not seekable");
+	start = static_cast<uint64_t>(pos);
+
+	char header[headerSize];
+	if (!in.read(header, headerSize))
+		throw container_error("Truncated container header");
+	if (std::memcmp(header, magic, sizeof(magic)) != 0)
+		throw container_error("Not a cipher container");
+	if (getU32(header + 44) != crc32(header, 44))
+		throw container_error("Container header checksum mismatch");
+	if ((static_cast<unsigned char>(header[4]) | (static_cast<unsigned char>(header[5]) << 8)) != version)
+		throw container_error("Unsupported container version");
+
+	unsigned char k = header[6];
+	if (k != static_cast<unsigned char>(cipherKind::gronsfeld) &&
+	    k != static_cast<unsigned char>(cipherKind::route))
+		throw container_error("Unknown cipher kind");
+	kind = static_cast<cipherKind>(k);
+	chunkLetters = getU32(header + 8);
+	keyCheck = getU32(header + 12);
+	uint64_t chunkCount = getU64(header + 16);
+	totalLetters = getU64(header + 24);
+	uint64_t indexOffset = getU64(header + 32);
+	uint32_t indexCrc = getU32(header + 40);
+
+	if (chunkLetters == 0 ||
+	    chunkCount != (totalLetters + chunkLetters - 1) / chunkLetters ||
+	    indexOffset < headerSize)
+		throw container_error("Corrupted container header");
+
+	// Размер индекса берется из заголовка: до выделения памяти сверяем его
+	// с длиной потока, CRC заголовка от подделанного файла не защищает
+	in.seekg(0, std::ios::end);
+	std::streampos end = in.tellg();
+	if (end == std::streampos(-1) || static_cast<uint64_t>(end) < start)
+		throw container_error("Input stream is not seekable");
+	uint64_t available = static_cast<uint64_t>(end) - start;
+	if (chunkCount > SIZE_MAX / indexEntrySize ||
+	    indexOffset > available ||
+	    chunkCount * indexEntrySize > available - indexOffset)
+		throw container_error("Truncated container index");
+
+	std::string indexBytes(chunkCount * indexEntrySize, '\0');
+	in.seekg(static_cast<std::streamoff>(start + indexOffset));
+	if (!in.read(&indexBytes[0], indexBytes.size()))
+		throw container_error("Truncated container index");
+	if (crc32(indexBytes) != indexCrc)
+		throw container_error("Container index checksum mismatch");
+
+	index.resize(chunkCount);
+	uint64_t expected = headerSize;
+	for (size_t i = 0; i < index.size(); i++) {
+		const char* p = indexBytes.data() + i * indexEntrySize;
+		index[i].offset = getU64(p);
+		index[i].size = getU32(p + 8);
+		index[i].letters = getU32(p + 12);
+		index[i].crc = getU32(p + 16);
+		uint32_t letters = (i + 1 < index.size())
+			? chunkLetters
+			: static_cast<uint32_t>(totalLetters - i * static_cast<uint64_t>(chunkLetters));
+		if (index[i].offset != expected || index[i].letters != letters)
+			throw container_error("Corrupted container index");
+		expected += index[i].size;
+	}
+	if (expected != indexOffset)
+		throw container_error("Corrupted container index");
+}
+
+const containerChunk& cipherContainerReader::getChunk(size_t i) const
+{
+	if (i >= index.size())
+		throw container_error("No chunk " + std::to_string(i));
+	return index[i];
+}
+
+std::string cipherContainerReader::readChunk(size_t i)
+{
+	const containerChunk& ch = getChunk(i);
+	std::string payload(ch.size, '\0');
+	{
+		std::lock_guard<std::mutex> lock(inLock);
+		in.clear();
+		in.seekg(static_cast<std::streamoff>(start + ch.offset));
+		in.read(&payload[0], payload.size());
+		if (!in)
+			throw container_error("Truncated chunk " + std::to_string(i));
+	}
+	if (crc32(payload) != ch.crc)
+		throw container_error("Chunk " + std::to_string(i) + " checksum mismatch");
+	return payload;
+}
+
+void cipherContainerReader::checkCipher(const containerCipher& c) const
+{
+	if (c.kind != kind || c.check() != keyCheck)
+		throw container_error("Cipher parameters do not match container");
+}
+
+std::wstring cipherContainerReader::decryptChunk(size_t i, const containerCipher& c)
+{
+	checkCipher(c);
+	std::wstring text = fromUtf8(readChunk(i));
+	if (text.size() != index[i].letters)
+		throw container_error("Chunk " + std::to_string(i) + " length mismatch");
+	return decryptText(c, text);
+}
+
+void cipherContainerReader::decryptAll(const containerCipher& c,
+                                       const std::function<void(size_t, const std::wstring&)>& sink,
+                                       unsigned thread_count)
+{
+	checkCipher(c);
+	parallelFor(index.size(), thread_count, [&](size_t i) {
+		sink(i, decryptChunk(i, c));
+	});
+}
+
+std::wstring cipherContainerReader::decryptAll(const containerCipher& c, unsigned thread_count)
+{
+	std::wstring result(totalLetters, L'\0');
+	decryptAll(c, [&](size_t i, const std::wstring& text) {
+		std::copy(text.begin(), text.end(), result.begin() + i * chunkLetters);
+	}, thread_count);
+	return result;
+}
+
+bool cipherContainerReader::verify(unsigned thread_count)
+{
+	try {
+		parallelFor(index.size(), thread_count, [&](size_t i) {
+			readChunk(i);
+		});
+	} catch (const container_error&) {
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Бинарный контейнер шифротекста.
+//
+// Открытый текст режется на блоки по chunkLetters букв, каждый блок шифруется
+// независимо (ключ modAlphaCipher начинается заново, routeCipher строит свою
+// таблицу), поэтому любой блок можно расшифровать отдельно и параллельно.
+//
+// Формат (все числа little-endian):
+//   заголовок, 48 байт:
+//     0  magic "GRCC"          8  chunkLetters u32     24 totalLetters u64
+//     4  version u16           12 keyCheck u32         32 indexOffset u64
+//     6  kind u8               16 chunkCount u64       40 indexCrc u32
+//     7  reserved u8                                   44 headerCrc u32
+//   блоки: шифротекст в UTF-8, подряд;
+//   индекс по indexOffset: chunkCount записей по 20 байт
+//     (offset u64, size u32, letters u32, crc u32).
+// keyCheck - CRC32 параметров шифра, позволяет отличить неверный ключ
+// от поврежденных данных. Сам ключ в контейнер не пишется, но keyCheck
+// не секрет и не защита: это проверка от опечатки в ключе. CRC32 без соли
+// считается мгновенно, поэтому по нему короткий ключ подбирается перебором
+// без единой попытки расшифрования.
+
+class container_error: public std::invalid_argument {
+public:
+	explicit container_error (const std::string& what_arg):
+		std::invalid_argument(what_arg) {}
+	explicit container_error (const char* what_arg):
+		std::invalid_argument(what_arg) {}
+};
+
+enum class cipherKind : uint8_t {
+	gronsfeld = 1, // modAlphaCipher
+	route = 2      // routeCipher
+};
+
+// Шифр и его параметры для записи и чтения контейнера
+struct containerCipher {
+	cipherKind kind;
+	std::wstring key; // ключ modAlphaCipher
+	int columns;      // число столбцов routeCipher
+
+	static containerCipher gronsfeld(const std::wstring& key);
+	static containerCipher route(int columns);
+	uint32_t check() const;
+};
+
+// Запись индекса: где лежит блок и как его проверить
+struct containerChunk {
+	uint64_t offset;
+	uint32_t size;
+	uint32_t letters;
+	uint32_t crc;
+};
+
+class cipherContainerWriter
+{
+private:
+	std::ostream& out;
+	containerCipher cipher;
+	uint32_t chunkLetters;
+	unsigned threads;
+	std::wstring pending; // буквы, еще не набравшие полный блок
+	std::vector<containerChunk> index;
+	uint64_t totalLetters = 0;
+	uint64_t start;
+	bool finished = false;
+	void flushChunks(size_t letters);
+public:
+	cipherContainerWriter()=delete;
+	// threads = 0 - по числу ядер
+	cipherContainerWriter(std::ostream& os, const containerCipher& c,
+	                      uint32_t chunk_letters = 65536, unsigned thread_count = 0);
+	void write(const std::wstring& open_text); // не-буквы отбрасываются, как в шифрах
+	void finish(); // дописывает хвост и индекс, заполняет заголовок
+};
+
+class cipherContainerReader
+{
+private:
+	std::istream& in;
+	std::mutex inLock; // поток ввода один на всех рабочих
+	uint64_t start;
+	cipherKind kind;
+	uint32_t chunkLetters;
+	uint32_t keyCheck;
+	uint64_t totalLetters;
+	std::vector<containerChunk> index;
+	std::string readChunk(size_t i);
+	void checkCipher(const containerCipher& c) const;
+public:
+	cipherContainerReader()=delete;
+	explicit cipherContainerReader(std::istream& is); // читает заголовок и индекс
+
+	cipherKind getKind() const { return kind; }
+	uint32_t getChunkLetters() const { return chunkLetters; }
+	uint64_t getTotalLetters() const { return totalLetters; }
+	size_t getChunkCount() const { return index.size(); }
+	const containerChunk& getChunk(size_t i) const; // container_error, если блока нет
+
+	std::wstring decryptChunk(size_t i, const containerCipher& c);
+	// sink вызывается из рабочих потоков, порядок блоков не гарантирован
+	void decryptAll(const containerCipher& c,
+	                const std::function<void(size_t, const std::wstring&)>& sink,
+	                unsigned thread_count = 0);
+	std::wstring decryptAll(const containerCipher& c, unsigned thread_count = 0);
+	bool verify(unsigned thread_count = 0); // проверка CRC всех блоков без расшифрования
+};
@@ -0,0 +1,27 @@
+#include "cipherProfile.h"
+
+#ifdef CIPHER_PROFILE
+
+#include <cstdlib>
+#include <new>
+
+// Замена operator new для профилирующей сборки: считает выделения потока
+// для allocations в CIPHER_STAGE. Варианты new[] и nothrow в libstdc++
+// вызывают эту же функцию, освобождение остается стандартным (free).
+void* operator new(std::size_t size)
+{
+	threadAllocations()++;
+	if (size == 0)
+		size = 1;
+	for (;;) {
+		void* p = std::malloc(size);
+		if (p)
+			return p;
+		std::new_handler handler = std::get_new_handler();
+		if (!handler)
+			throw std::bad_alloc();
+		handler();
+	}
+}
+
+#endif
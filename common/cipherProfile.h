@@ -0,0 +1,242 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Поэтапные счетчики горячего пути шифров.
+//
+// Включаются сборкой с -DCIPHER_PROFILE (make PROFILE=1). Без флага макросы
+// CIPHER_STAGE раскрываются в пустоту, а takeProfile() возвращает нули,
+// поэтому в обычной сборке инструментирование ничего не стоит.
+// Счетчики свои у каждого потока и пишутся только им самим: relaxed load и
+// store без read-modify-write. Блок потока регистрируется в общем списке,
+// поэтому снимок и сброс с profileScope::allThreads суммируют все потоки,
+// включая завершившиеся (их итог переносится в список при выходе потока).
+// Сброс чужих счетчиков во время замера может потерять этот сброс для
+// текущего этапа: поток допишет значение, прочитанное до обнуления.
+//
+// allocations - вызовы operator new в потоке за время этапа. Их считает
+// замена operator new из cipherProfile.cpp, которая компонуется в программы
+// только при -DCIPHER_PROFILE. Выделения из арены pmr кучу не трогают и не
+// считаются, пока арене хватает буфера. libcipher замену не подключает:
+// operator new подменяет программа, а не библиотека.
+
+enum class profileStage {
+    validate,  // проверка входа вместе с приведением к верхнему регистру
+    convert,   // перевод букв в номера алфавита
+    transform, // сдвиг или заполнение таблицы перестановки
+    output     // сборка выходной строки
+};
+const int profileStageCount = 4;
+
+struct stageCounters {
+    uint64_t calls = 0;
+    uint64_t nanoseconds = 0;
+    uint64_t bytes = 0;       // объем входа этапа
+    uint64_t allocations = 0; // вызовы operator new за время этапа
+};
+
+struct profileSnapshot {
+    stageCounters stages[profileStageCount];
+    const stageCounters& operator[](profileStage s) const { return stages[static_cast<int>(s)]; }
+};
+
+inline const char* stageName(profileStage s)
+{
+    switch (s) {
+    case profileStage::validate:
+        return "validate";
+    case profileStage::convert:
+        return "convert";
+    case profileStage::transform:
+        return "transform";
+    case profileStage::output:
+        return "output";
+    }
+    return "unknown";
+}
+
+// Чьи счетчики берет снимок или сброс
+enum class profileScope {
+    thisThread, // только вызывающий поток
+    allThreads  // все потоки процесса, живые и завершившиеся
+};
+
+#ifdef CIPHER_PROFILE
+
+const bool profileEnabled = true;
+
+// Прибавление к счетчику, который пишет только поток-владелец
+inline void addCounter(std::atomic<uint64_t>& counter, uint64_t value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+struct atomicStageCounters {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> nanoseconds{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> allocations{0};
+};
+
+class threadCounters;
+
+// Общий список блоков счетчиков живых потоков и итог завершившихся
+struct profileRegistry {
+    std::mutex lock;
+    std::vector<threadCounters*> threads;
+    profileSnapshot retired;
+};
+
+inline profileRegistry& globalProfile()
+{
+    static profileRegistry registry;
+    return registry;
+}
+
+inline void addSnapshot(profileSnapshot& total, const profileSnapshot& part)
+{
+    for (int i = 0; i < profileStageCount; i++) {
+        total.stages[i].calls += part.stages[i].calls;
+        total.stages[i].nanoseconds += part.stages[i].nanoseconds;
+        total.stages[i].bytes += part.stages[i].bytes;
+        total.stages[i].allocations += part.stages[i].allocations;
+    }
+}
+
+// Блок счетчиков одного потока, живет в его thread_local
+class threadCounters
+{
+public:
+    atomicStageCounters stages[profileStageCount];
+
+    threadCounters()
+    {
+        profileRegistry& registry = globalProfile();
+        std::lock_guard<std::mutex> guard(registry.lock);
+        registry.threads.push_back(this);
+    }
+    ~threadCounters()
+    {
+        profileRegistry& registry = globalProfile();
+        std::lock_guard<std::mutex> guard(registry.lock);
+        addSnapshot(registry.retired, snapshot());
+        for (size_t i = 0; i < registry.threads.size(); i++) {
+            if (registry.threads[i] == this) {
+                registry.threads[i] = registry.threads.back();
+                registry.threads.pop_back();
+                break;
+            }
+        }
+    }
+    threadCounters(const threadCounters&) = delete;
+    threadCounters& operator=(const threadCounters&) = delete;
+
+    profileSnapshot snapshot() const
+    {
+        profileSnapshot result;
+        for (int i = 0; i < profileStageCount; i++) {
+            result.stages[i].calls = stages[i].calls.load(std::memory_order_relaxed);
+            result.stages[i].nanoseconds = stages[i].nanoseconds.load(std::memory_order_relaxed);
+            result.stages[i].bytes = stages[i].bytes.load(std::memory_order_relaxed);
+            result.stages[i].allocations = stages[i].allocations.load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+    void reset()
+    {
+        for (auto& st : stages) {
+            st.calls.store(0, std::memory_order_relaxed);
+            st.nanoseconds.store(0, std::memory_order_relaxed);
+            st.bytes.store(0, std::memory_order_relaxed);
+            st.allocations.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+inline threadCounters& threadProfile()
+{
+    static thread_local threadCounters counters;
+    return counters;
+}
+
+// Вызовы operator new в потоке, увеличивает замена из cipherProfile.cpp
+inline uint64_t& threadAllocations()
+{
+    static thread_local uint64_t count = 0;
+    return count;
+}
+
+// Замер одного этапа на время жизни объекта
+class stageScope
+{
+private:
+    atomicStageCounters& counters;
+    uint64_t startAllocations;
+    std::chrono::steady_clock::time_point start;
+public:
+    stageScope(profileStage s, size_t bytes):
+        counters(threadProfile().stages[static_cast<int>(s)]),
+        startAllocations(threadAllocations()),
+        start(std::chrono::steady_clock::now())
+    {
+        addCounter(counters.calls, 1);
+        addCounter(counters.bytes, bytes);
+    }
+    ~stageScope()
+    {
+        addCounter(counters.nanoseconds, std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        addCounter(counters.allocations, threadAllocations() - startAllocations);
+    }
+    stageScope(const stageScope&) = delete;
+    stageScope& operator=(const stageScope&) = delete;
+};
+
+#define CIPHER_STAGE(stage, bytes) \
+    stageScope cipherStageScope(profileStage::stage, (bytes))
+
+inline profileSnapshot takeProfile(profileScope scope = profileScope::thisThread)
+{
+    if (scope == profileScope::thisThread)
+        return threadProfile().snapshot();
+    profileRegistry& registry = globalProfile();
+    std::lock_guard<std::mutex> guard(registry.lock);
+    profileSnapshot total = registry.retired;
+    for (const threadCounters* t : registry.threads)
+        addSnapshot(total, t->snapshot());
+    return total;
+}
+
+inline void resetProfile(profileScope scope = profileScope::thisThread)
+{
+    if (scope == profileScope::thisThread) {
+        threadProfile().reset();
+        return;
+    }
+    profileRegistry& registry = globalProfile();
+    std::lock_guard<std::mutex> guard(registry.lock);
+    registry.retired = profileSnapshot();
+    for (threadCounters* t : registry.threads)
+        t->reset();
+}
+
+#else
+
+const bool profileEnabled = false;
+
+#define CIPHER_STAGE(stage, bytes) ((void)0)
+
+inline profileSnapshot takeProfile(profileScope = profileScope::thisThread)
+{
+    return profileSnapshot();
+}
+
+inline void resetProfile(profileScope = profileScope::thisThread)
+{
+}
+
+#endif
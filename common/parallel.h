@@ -0,0 +1,67 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Число рабочих потоков: 0 означает "по числу ядер"
+inline unsigned resolveThreads(unsigned threads, size_t tasks)
+{
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+    if (tasks < threads) {
+        threads = tasks == 0 ? 1 : static_cast<unsigned>(tasks);
+    }
+    return threads;
+}
+
+// Выполняет body(i) для i из [0, count) на нескольких потоках.
+// Задачи раздаются по одной через атомарный счетчик; первое исключение
+// из рабочего потока останавливает раздачу и пробрасывается вызывающему.
+template <class Body>
+void parallelFor(size_t count, unsigned threads, Body body)
+{
+    threads = resolveThreads(threads, count);
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            body(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::exception_ptr error;
+    std::mutex errorLock;
+    auto worker = [&]() {
+        try {
+            for (size_t i = next++; i < count; i = next++) {
+                body(i);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorLock);
+            if (!error) {
+                error = std::current_exception();
+            }
+            next = count;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& th : pool) {
+        th.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
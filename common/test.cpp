@@ -0,0 +1,353 @@
+#include <iostream>
+#include <locale>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cipherCache.h"
+#include "cipherContainer.h"
+
+using namespace std;
+
+// ===================== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ =====================
+int total_tests = 0;
+int passed_tests = 0;
+
+void assert_true(bool condition, const string& message) {
+    total_tests++;
+    if (condition) {
+        passed_tests++;
+        cout << "✓ " << message << endl;
+    } else {
+        cout << "✗ " << message << endl;
+    }
+}
+
+void assert_exception(void (*func)(), const string& message) {
+    total_tests++;
+    try {
+        func();
+        cout << "✗ " << message << " (ожидалось исключение)" << endl;
+    } catch (const container_error& e) {
+        passed_tests++;
+        cout << "✓ " << message << endl;
+    } catch (...) {
+        cout << "✗ " << message << " (неожиданное исключение)" << endl;
+    }
+}
+
+void print_section(const string& section_name) {
+    cout << "\n" << string(60, '=') << endl;
+    cout << section_name << endl;
+    cout << string(60, '=') << endl;
+}
+
+const wstring sample_text = L"ЭТООЧЕНЬДЛИННЫЙТЕКСТДЛЯПРОВЕРКИРАБОТЫШИФРАВКОНТЕЙНЕРЕ";
+
+string pack(const containerCipher& c, const wstring& text, uint32_t chunk, unsigned threads = 1) {
+    ostringstream out(ios::binary);
+    cipherContainerWriter writer(out, c, chunk, threads);
+    writer.write(text);
+    writer.finish();
+    return out.str();
+}
+
+// Заголовок с подделанным полем u64 и пересчитанной CRC, как у настоящего файла
+void forge_header(string& data, size_t offset, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        data[offset + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+    uint32_t crc = ~0u;
+    for (size_t i = 0; i < 44; i++) {
+        crc ^= static_cast<unsigned char>(data[i]);
+        for (int k = 0; k < 8; k++) {
+            crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+        }
+    }
+    crc = ~crc;
+    for (int i = 0; i < 4; i++) {
+        data[44 + i] = static_cast<char>((crc >> (8 * i)) & 0xFF);
+    }
+}
+
+// ===================== ТЕСТЫ КОНТЕЙНЕРА =====================
+void test_container() {
+    print_section("ТЕСТЫ КОНТЕЙНЕРА ШИФРОТЕКСТА");
+
+    assert_true([]() {
+        containerCipher c = containerCipher::gronsfeld(L"КЛЮЧ");
+        istringstream in(pack(c, sample_text, 8), ios::binary);
+        cipherContainerReader reader(in);
+        return reader.getKind() == cipherKind::gronsfeld
+            && reader.getChunkCount() == (sample_text.size() + 7) / 8
+            && reader.getTotalLetters() == sample_text.size()
+            && reader.decryptAll(c, 1) == sample_text;
+    }(), "Полный цикл для modAlphaCipher");
+
+    assert_true([]() {
+        containerCipher c = containerCipher::route(5);
+        istringstream in(pack(c, sample_text, 11), ios::binary);
+        cipherContainerReader reader(in);
+        return reader.getKind() == cipherKind::route && reader.decryptAll(c, 1) == sample_text;
+    }(), "Полный цикл для routeCipher");
+
+    assert_true([]() {
+        containerCipher c = containerCipher::gronsfeld(L"ШИФР");
+        istringstream in(pack(c, sample_text, 8), ios::binary);
+        cipherContainerReader reader(in);
+        wstring piece = sample_text.substr(16, 8);
+        return reader.decryptChunk(2, c) == piece
+            && reader.decryptChunk(0, c) == sample_text.substr(0, 8);
+    }(), "Произвольный доступ к блоку");
+
+    assert_true([]() {
+        containerCipher c = containerCipher::route(3);
+        istringstream in(pack(c, sample_text, 4), ios::binary);
+        cipherContainerReader reader(in);
+        wstring last = sample_text.substr((reader.getChunkCount() - 1) * 4);
+        return reader.decryptChunk(reader.getChunkCount() - 1, c) == last;
+    }(), "Неполный последний блок");
+
+    assert_true([]() {
+        containerCipher c = containerCipher::gronsfeld(L"КЛЮЧ");
+        string one = pack(c, sample_text, 5, 1);
+        string many = pack(c, sample_text, 5, 4);
+        istringstream in(many, ios::binary);
+        cipherContainerReader reader(in);
+        return one == many && reader.decryptAll(c, 4) == sample_text;
+    }(), "Параллельная запись и чтение дают тот же результат");
+
+    assert_true([]() {
+        containerCipher c = containerCipher::gronsfeld(L"КЛЮЧ");
+        ostringstream out(ios::binary);
+        cipherContainerWriter writer(out, c, 6, 1);
+        writer.write(L"это очень длинный ");
+        writer.write(L"текст, 123 для проверки!");
+        writer.finish();
+        istringstream in(out.str(), ios::binary);
+        cipherContainerReader reader(in);
+        return reader.decryptAll(c) == L"ЭТООЧЕНЬДЛИННЫЙТЕКСТДЛЯПРОВЕРКИ";
+    }(), "Потоковая запись по частям с не-буквами");
+
+    assert_true([]() {
+        containerCipher c = containerCipher::route(4);
+        istringstream in(pack(c, L"", 16), ios::binary);
+        cipherContainerReader reader(in);
+        return reader.getChunkCount() == 0 && reader.decryptAll(c).empty() && reader.verify();
+    }(), "Пустой контейнер");
+
+    assert_true([]() {
+        containerCipher c = containerCipher::gronsfeld(L"КЛЮЧ");
+        string data = pack(c, sample_text, 8);
+        data[48 + 3] ^= 0x01;
+        istringstream in(data, ios::binary);
+        cipherContainerReader reader(in);
+        return !reader.verify();
+    }(), "verify обнаруживает поврежденный блок");
+
+    assert_exception([]() {
+        containerCipher c = containerCipher::gronsfeld(L"КЛЮЧ");
+        string data = pack(c, sample_text, 8);
+        data[48 + 3] ^= 0x01;
+        istringstream in(data, ios::binary);
+        cipherContainerReader reader(in);
+        reader.decryptChunk(0, c);
+    }, "Поврежденный блок при расшифровании");
+
+    assert_exception([]() {
+        string data = pack(containerCipher::gronsfeld(L"КЛЮЧ"), sample_text, 8);
+        istringstream in(data, ios::binary);
+        cipherContainerReader reader(in);
+        reader.decryptAll(containerCipher::gronsfeld(L"ДРУГОЙ"));
+    }, "Неверный ключ");
+
+    assert_exception([]() {
+        string data = pack(containerCipher::route(4), sample_text, 8);
+        istringstream in(data, ios::binary);
+        cipherContainerReader reader(in);
+        reader.decryptAll(containerCipher::gronsfeld(L"КЛЮЧ"));
+    }, "Неверный тип шифра");
+
+    assert_exception([]() {
+        string data = pack(containerCipher::route(4), sample_text, 8);
+        istringstream in(data, ios::binary);
+        cipherContainerReader reader(in);
+        reader.decryptChunk(reader.getChunkCount(), containerCipher::route(4));
+    }, "Номер блока за пределами контейнера");
+
+    assert_exception([]() {
+        string data = pack(containerCipher::route(4), sample_text, 8);
+        data[0] = 'X';
+        istringstream in(data, ios::binary);
+        cipherContainerReader reader(in);
+    }, "Неверная сигнатура");
+
+    assert_exception([]() {
+        string data = pack(containerCipher::route(4), sample_text, 8);
+        data[9] ^= 0x01;
+        istringstream in(data, ios::binary);
+        cipherContainerReader reader(in);
+    }, "Поврежденный заголовок");
+
+    assert_exception([]() {
+        string data = pack(containerCipher::route(4), sample_text, 8);
+        data[data.size() - 1] ^= 0x01;
+        istringstream in(data, ios::binary);
+        cipherContainerReader reader(in);
+    }, "Поврежденный индекс");
+
+    assert_exception([]() {
+        string data = pack(containerCipher::route(4), sample_text, 8);
+        istringstream in(data.substr(0, 20), ios::binary);
+        cipherContainerReader reader(in);
+    }, "Обрезанный заголовок");
+
+    // 2^40 блоков по 8 букв: индекс в 20 ТБ не выделяется, а отвергается
+    assert_exception([]() {
+        string data = pack(containerCipher::route(4), sample_text, 8).substr(0, 48);
+        forge_header(data, 16, uint64_t(1) << 40);
+        forge_header(data, 24, uint64_t(1) << 43);
+        istringstream in(data, ios::binary);
+        cipherContainerReader reader(in);
+    }, "Число блоков больше файла");
+
+    assert_exception([]() {
+        string data = pack(containerCipher::route(4), sample_text, 8);
+        forge_header(data, 32, ~uint64_t(0) - 8);
+        istringstream in(data, ios::binary);
+        cipherContainerReader reader(in);
+    }, "Смещение индекса за концом файла");
+
+    assert_exception([]() {
+        ostringstream out(ios::binary);
+        cipherContainerWriter writer(out, containerCipher::route(4), 0);
+    }, "Нулевой размер блока");
+}
+
+// ===================== ТЕСТЫ КЭША ШИФРОВ =====================
+void test_cache() {
+    print_section("ТЕСТЫ КЭША ПОДГОТОВЛЕННЫХ ШИФРОВ");
+
+    assert_true([]() {
+        cipherCache cache(4);
+        auto a = cache.gronsfeld(L"КЛЮЧ");
+        auto b = cache.gronsfeld(L"КЛЮЧ");
+        cacheStats s = cache.stats();
+        return a == b && s.hits == 1 && s.misses == 1 && s.size == 1;
+    }(), "Повторный запрос возвращает тот же объект");
+
+    assert_true([]() {
+        cipherCache cache(4);
+        auto cached = cache.gronsfeld(L"ШИФР");
+        modAlphaCipher direct(L"ШИФР");
+        auto route = cache.route(5);
+        routeCipher directRoute(5);
+        return cached->encrypt(sample_text) == direct.encrypt(sample_text)
+            && route->encrypt(sample_text) == directRoute.encrypt(sample_text);
+    }(), "Кэшированный шифр совпадает с созданным напрямую");
+
+    assert_true([]() {
+        cipherCache cache(2);
+        cache.route(1);
+        cache.route(2);
+        cache.route(1);    // 1 становится самым свежим
+        cache.route(3);    // вытесняет 2
+        cache.route(1);    // попадание
+        cache.route(2);    // промах
+        cacheStats s = cache.routeStats();
+        return s.hits == 2 && s.misses == 4 && s.evictions == 2 && s.size == 2;
+    }(), "Вытеснение давно не использованного");
+
+    assert_true([]() {
+        cipherCache cache(1);
+        auto held = cache.gronsfeld(L"ПЕРВЫЙ");
+        cache.gronsfeld(L"ВТОРОЙ");
+        return held->decrypt(held->encrypt(L"ТЕКСТ")) == L"ТЕКСТ"
+            && cache.gronsfeldStats().evictions == 1;
+    }(), "Вытесненный объект остается рабочим");
+
+    assert_true([]() {
+        cipherCache cache(4);
+        bool keyThrown = false;
+        bool columnsThrown = false;
+        try {
+            cache.gronsfeld(L"ключ123");
+        } catch (const cipher_error&) {
+            keyThrown = true;
+        }
+        try {
+            cache.route(0);
+        } catch (const route_cipher_error&) {
+            columnsThrown = true;
+        }
+        return keyThrown && columnsThrown && cache.stats().size == 0;
+    }(), "Неверный ключ не попадает в кэш");
+
+    assert_true([]() {
+        cipherCache cache(8);
+        const wstring keys[] = {L"А", L"БВ", L"ГДЕ", L"ЖЗИЙ"};
+        vector<thread> pool;
+        vector<int> ok(8, 1);
+        for (int t = 0; t < 8; t++) {
+            pool.emplace_back([&, t]() {
+                for (int i = 0; i < 500; i++) {
+                    const wstring& key = keys[(t + i) % 4];
+                    auto c = cache.gronsfeld(key);
+                    if (c->decrypt(c->encrypt(sample_text)) != sample_text) {
+                        ok[t] = 0;
+                    }
+                }
+            });
+        }
+        for (auto& th : pool) {
+            th.join();
+        }
+        cacheStats s = cache.stats();
+        for (int v : ok) {
+            if (!v) {
+                return false;
+            }
+        }
+        return s.hits + s.misses == 4000 && s.size == 4;
+    }(), "Одновременный доступ из нескольких потоков");
+
+    assert_true([]() {
+        cipherCache cache(4);
+        cache.route(4);
+        cache.gronsfeld(L"КЛЮЧ");
+        cache.clear();
+        return cache.stats().size == 0;
+    }(), "Очистка кэша");
+}
+
+// ===================== ГЛАВНАЯ ФУНКЦИЯ =====================
+int main() {
+    // Настройка локали
+    locale::global(locale("ru_RU.UTF-8"));
+    wcout.imbue(locale());
+
+    cout << "\n" << string(70, '=') << endl;
+    cout << "МОДУЛЬНОЕ ТЕСТИРОВАНИЕ ОБЩИХ КОМПОНЕНТОВ" << endl;
+    cout << string(70, '=') << endl;
+
+    // Запуск всех тестов
+    test_container();
+    test_cache();
+
+    // Итоги
+    cout << "\n" << string(70, '=') << endl;
+    cout << "ИТОГИ ТЕСТИРОВАНИЯ" << endl;
+    cout << string(70, '=') << endl;
+
+    cout << "Всего тестов: " << total_tests << endl;
+    cout << "Пройдено: " << passed_tests << endl;
+    cout << "Не пройдено: " << (total_tests - passed_tests) << endl;
+
+    if (passed_tests == total_tests) {
+        cout << "\n✓ ВСЕ ТЕСТЫ УСПЕШНО ПРОЙДЕНЫ!" << endl;
+        return 0;
+    } else {
+        cout << "\n✗ ТЕСТИРОВАНИЕ НЕ УСПЕШНО" << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,215 @@
+#include "cipherProtocol.h"
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+const size_t requestHeader = 16;
+const size_t replyHeader = 12;
+
+void putU16(std::string& out, uint16_t v)
+{
+	out.push_back(static_cast<char>(v & 0xFF));
+	out.push_back(static_cast<char>(v >> 8));
+}
+
+void putU32(std::string& out, uint32_t v)
+{
+	for (int i = 0; i < 4; i++) {
+		out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+	}
+}
+
+uint16_t getU16(const char* p)
+{
+	return static_cast<uint16_t>(static_cast<unsigned char>(p[0]) | (static_cast<unsigned char>(p[1]) << 8));
+}
+
+uint32_t getU32(const char* p)
+{
+	uint32_t v = 0;
+	for (int i = 3; i >= 0; i--) {
+		v = (v << 8) | static_cast<unsigned char>(p[i]);
+	}
+	return v;
+}
+
+// Длина кадра вместе с полем size, 0 - если кадр еще не пришел целиком
+size_t frameLength(const char* data, size_t size, size_t header)
+{
+	if (size < 4) {
+		return 0;
+	}
+	uint32_t body = getU32(data);
+	if (body > maxFrameSize) {
+		throw protocol_error("Frame is too large");
+	}
+	if (body + 4 < header) {
+		throw protocol_error("Frame is too short");
+	}
+	return size < body + 4 ? 0 : body + 4;
+}
+
+std::string systemError(const char* what)
+{
+	return std::string(what) + ": " + std::strerror(errno);
+}
+
+}
+
+void encodeRequest(const cipherRequest& r, std::string& out)
+{
+	if (r.key.size() > 0xFFFF) {
+		throw protocol_error("Key is too long");
+	}
+	size_t body = requestHeader - 4 + r.key.size() + r.text.size();
+	if (body > maxFrameSize) {
+		throw protocol_error("Frame is too large");
+	}
+	putU32(out, static_cast<uint32_t>(body));
+	putU32(out, r.id);
+	out.push_back(static_cast<char>(r.op));
+	out.push_back(static_cast<char>(r.kind));
+	putU16(out, static_cast<uint16_t>(r.key.size()));
+	putU32(out, r.columns);
+	out += r.key;
+	out += r.text;
+}
+
+void encodeReply(const cipherReply& r, std::string& out)
+{
+	size_t body = replyHeader - 4 + r.text.size();
+	if (body > maxFrameSize) {
+		throw protocol_error("Frame is too large");
+	}
+	putU32(out, static_cast<uint32_t>(body));
+	putU32(out, r.id);
+	out.push_back(static_cast<char>(r.status));
+	out.append(3, '\0');
+	out += r.text;
+}
+
+size_t decodeRequest(const char* data, size_t size, cipherRequest& r)
+{
+	size_t length = frameLength(data, size, requestHeader);
+	if (length == 0) {
+		return 0;
+	}
+	uint8_t op = data[8];
+	uint8_t kind = data[9];
+	if (op != static_cast<uint8_t>(cipherOp::encrypt) && op != static_cast<uint8_t>(cipherOp::decrypt)) {
+		throw protocol_error("Unknown operation");
+	}
+	if (kind != static_cast<uint8_t>(cipherKind::gronsfeld) && kind != static_cast<uint8_t>(cipherKind::route)) {
+		throw protocol_error("Unknown cipher kind");
+	}
+	size_t keySize = getU16(data + 10);
+	if (requestHeader + keySize > length) {
+		throw protocol_error("Key exceeds frame");
+	}
+	r.id = getU32(data + 4);
+	r.op = static_cast<cipherOp>(op);
+	r.kind = static_cast<cipherKind>(kind);
+	r.columns = getU32(data + 12);
+	r.key.assign(data + requestHeader, keySize);
+	r.text.assign(data + requestHeader + keySize, length - requestHeader - keySize);
+	return length;
+}
+
+size_t decodeReply(const char* data, size_t size, cipherReply& r)
+{
+	size_t length = frameLength(data, size, replyHeader);
+	if (length == 0) {
+		return 0;
+	}
+	uint8_t status = data[8];
+	if (status > static_cast<uint8_t>(replyStatus::badRequest)) {
+		throw protocol_error("Unknown reply status");
+	}
+	r.id = getU32(data + 4);
+	r.status = static_cast<replyStatus>(status);
+	r.text.assign(data + replyHeader, length - replyHeader);
+	return length;
+}
+
+// =========== КЛИЕНТ ===========
+
+cipherClient::cipherClient(const std::string& socket_path)
+{
+	sockaddr_un addr = {};
+	addr.sun_family = AF_UNIX;
+	if (socket_path.size() >= sizeof(addr.sun_path)) {
+		throw protocol_error("Socket path is too long");
+	}
+	std::memcpy(addr.sun_path, socket_path.c_str(), socket_path.size() + 1);
+	fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		throw std::runtime_error(systemError("socket"));
+	}
+	if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+		std::string message = systemError("connect");
+		::close(fd);
+		throw std::runtime_error(message);
+	}
+}
+
+cipherClient::~cipherClient()
+{
+	::close(fd);
+}
+
+void cipherClient::send(const cipherRequest& r)
+{
+	std::string frame;
+	encodeRequest(r, frame);
+	sendRaw(frame);
+}
+
+void cipherClient::sendRaw(const std::string& bytes)
+{
+	size_t sent = 0;
+	while (sent < bytes.size()) {
+		ssize_t n = ::send(fd, bytes.data() + sent, bytes.size() - sent, MSG_NOSIGNAL);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw std::runtime_error(systemError("send"));
+		}
+		sent += n;
+	}
+}
+
+void cipherClient::shutdownWrite()
+{
+	if (::shutdown(fd, SHUT_WR) < 0) {
+		throw std::runtime_error(systemError("shutdown"));
+	}
+}
+
+cipherReply cipherClient::receive()
+{
+	cipherReply r;
+	char buffer[65536];
+	for (;;) {
+		size_t length = decodeReply(in.data(), in.size(), r);
+		if (length != 0) {
+			in.erase(0, length);
+			return r;
+		}
+		ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n < 0) {
+			throw std::runtime_error(systemError("recv"));
+		}
+		if (n == 0) {
+			throw std::runtime_error("Connection closed by server");
+		}
+		in.append(buffer, n);
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include "../common/cipherContainer.h"
+
+// Протокол демона шифрования поверх Unix-сокета.
+// Кадры идут подряд в обе стороны, клиент может отправлять запросы не дожидаясь
+// ответов; ответы приходят в порядке готовности, их связывает с запросом id.
+// Все числа little-endian, строки - UTF-8.
+//
+//   запрос:  0 size u32       8 op u8 (1 - encrypt, 2 - decrypt)   12 columns u32
+//            4 id u32         9 kind u8 (cipherKind)               16 key, затем text
+//                             10 keySize u16
+//   ответ:   0 size u32       8 status u8 (replyStatus)            12 text
+//            4 id u32         9..11 reserved
+// size - длина кадра без поля size. key - ключ modAlphaCipher,
+// columns - число столбцов routeCipher; неиспользуемое поле шифр не читает.
+
+class protocol_error: public std::invalid_argument {
+public:
+	explicit protocol_error (const std::string& what_arg):
+		std::invalid_argument(what_arg) {}
+	explicit protocol_error (const char* what_arg):
+		std::invalid_argument(what_arg) {}
+};
+
+enum class cipherOp : uint8_t {
+	encrypt = 1,
+	decrypt = 2
+};
+
+enum class replyStatus : uint8_t {
+	ok = 0,
+	cipherError = 1, // ключ или текст отвергнуты шифром, text - сообщение
+	badRequest = 2   // кадр не разобран, соединение будет закрыто
+};
+
+const size_t maxFrameSize = 16 << 20;
+
+struct cipherRequest {
+	uint32_t id = 0;
+	cipherOp op = cipherOp::encrypt;
+	cipherKind kind = cipherKind::gronsfeld;
+	std::string key; // UTF-8
+	uint32_t columns = 0;
+	std::string text; // UTF-8
+};
+
+struct cipherReply {
+	uint32_t id = 0;
+	replyStatus status = replyStatus::ok;
+	std::string text; // UTF-8: результат или сообщение об ошибке
+};
+
+// Кадр дописывается в конец out
+void encodeRequest(const cipherRequest& r, std::string& out);
+void encodeReply(const cipherReply& r, std::string& out);
+// Разбор кадра в начале буфера: 0 - кадр пришел не полностью,
+// иначе длина разобранного кадра. Испорченный кадр - protocol_error.
+size_t decodeRequest(const char* data, size_t size, cipherRequest& r);
+size_t decodeReply(const char* data, size_t size, cipherReply& r);
+
+// Блокирующий клиент: одно соединение, запросы можно отправлять пачкой
+class cipherClient
+{
+private:
+	int fd;
+	std::string in; // принятые, но еще не разобранные байты
+public:
+	cipherClient()=delete;
+	explicit cipherClient(const std::string& socket_path);
+	cipherClient(const cipherClient&)=delete;
+	cipherClient& operator=(const cipherClient&)=delete;
+	~cipherClient();
+
+	void send(const cipherRequest& r);
+	void sendRaw(const std::string& bytes);
+	void shutdownWrite();  // больше запросов не будет; ответы на отправленные придут
+	cipherReply receive(); // следующий ответ в порядке прихода
+	cipherReply call(const cipherRequest& r) { send(r); return receive(); }
+};
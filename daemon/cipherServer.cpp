@@ -0,0 +1,485 @@
+#include "cipherServer.h"
+#include "../common/parallel.h"
+#include <algorithm>
+#include <cerrno>
+#include <codecvt>
+#include <cstring>
+#include <iterator>
+#include <locale>
+#include <memory_resource>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Метки событий epoll; соединения нумеруются с единицы
+const uint64_t listenTag = 0;
+const uint64_t wakeTag = ~uint64_t(0);
+
+// Пределы очереди одного соединения, после которых его чтение приостанавливается
+const size_t maxInflight = 1024;          // запросов в работе
+const size_t maxQueuedOutput = 4 << 20;   // байт ответов, не принятых сокетом
+const size_t maxBufferedInput = maxFrameSize + 4; // в буфере уже есть целый кадр
+
+// Запросов в одном пакете рабочего: группа одного ключа делится на такие части
+const size_t maxBatchRequests = 64;
+
+std::string systemError(const char* what)
+{
+	return std::string(what) + ": " + std::strerror(errno);
+}
+
+}
+
+cipherServer::cipherServer(const std::string& socket_path, unsigned worker_count,
+                           unsigned batch_us, size_t cache_capacity)
+	: path(socket_path), batchMicros(batch_us), cache(cache_capacity)
+{
+	sockaddr_un addr = {};
+	addr.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(addr.sun_path)) {
+		throw server_error("Socket path is too long");
+	}
+	std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+	auto fail = [this](const char* what) {
+		std::string message = systemError(what);
+		if (listenFd >= 0) ::close(listenFd);
+		if (epollFd >= 0) ::close(epollFd);
+		if (wakeFd >= 0) ::close(wakeFd);
+		throw server_error(message);
+	};
+
+	// Сокет, оставшийся от прошлого запуска, мешает bind. Удаляется он, только
+	// если на нем никто не слушает (connect - ECONNREFUSED): работающий сервер
+	// и другие файлы не трогаем
+	struct stat st;
+	if (::stat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+		int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (probe < 0) fail("socket");
+		int rc;
+		do {
+			rc = ::connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+		} while (rc < 0 && errno == EINTR);
+		int probeErrno = errno;
+		::close(probe);
+		if (rc == 0) {
+			throw server_error("Socket " + path + " is already in use");
+		}
+		if (probeErrno == ECONNREFUSED) {
+			::unlink(path.c_str());
+		}
+	}
+	listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (listenFd < 0) fail("socket");
+	if (::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) fail("bind");
+	if (::listen(listenFd, SOMAXCONN) < 0) fail("listen");
+	epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+	if (epollFd < 0) fail("epoll_create1");
+	wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (wakeFd < 0) fail("eventfd");
+
+	epoll_event ev = {};
+	ev.events = EPOLLIN;
+	ev.data.u64 = listenTag;
+	if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev) < 0) fail("epoll_ctl");
+	ev.data.u64 = wakeTag;
+	if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev) < 0) fail("epoll_ctl");
+
+	unsigned threads = resolveThreads(worker_count, static_cast<size_t>(-1));
+	for (unsigned t = 0; t < threads; t++) {
+		workers.emplace_back(&cipherServer::workerLoop, this);
+	}
+}
+
+cipherServer::~cipherServer()
+{
+	{
+		std::lock_guard<std::mutex> guard(tasksLock);
+		shuttingDown = true;
+	}
+	tasksReady.notify_all();
+	for (auto& w : workers) {
+		w.join();
+	}
+	for (auto& c : connections) {
+		::close(c.second->fd);
+	}
+	::close(listenFd);
+	::close(epollFd);
+	::close(wakeFd);
+	::unlink(path.c_str());
+}
+
+void cipherServer::stop()
+{
+	stopping = true;
+	uint64_t one = 1;
+	ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+	(void)ignored;
+}
+
+serverStats cipherServer::stats() const
+{
+	serverStats s;
+	s.connections = connectionCount;
+	s.requests = requestCount;
+	s.batches = batchCount;
+	s.throttled = throttleCount;
+	return s;
+}
+
+void cipherServer::run()
+{
+	epoll_event events[64];
+	while (!stopping) {
+		int timeout = -1;
+		if (!pending.empty()) {
+			// epoll ждет в миллисекундах: окно пакета округляется вверх
+			auto age = std::chrono::steady_clock::now() - pendingSince;
+			long long left = batchMicros - std::chrono::duration_cast<std::chrono::microseconds>(age).count();
+			timeout = left <= 0 ? 0 : static_cast<int>((left + 999) / 1000);
+		}
+		int n = ::epoll_wait(epollFd, events, 64, timeout);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw server_error(systemError("epoll_wait"));
+		}
+		for (int i = 0; i < n; i++) {
+			uint64_t tag = events[i].data.u64;
+			if (tag == listenTag) {
+				acceptConnections();
+			} else if (tag == wakeTag) {
+				uint64_t counter;
+				ssize_t ignored = ::read(wakeFd, &counter, sizeof(counter));
+				(void)ignored;
+				deliverReplies();
+			} else {
+				if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+					readConnection(tag);
+				}
+				if (events[i].events & EPOLLOUT) {
+					writeConnection(tag);
+				}
+			}
+		}
+		if (!pending.empty() && (batchMicros == 0 ||
+		    std::chrono::steady_clock::now() - pendingSince >= std::chrono::microseconds(batchMicros))) {
+			flushPending();
+		}
+	}
+}
+
+void cipherServer::acceptConnections()
+{
+	for (;;) {
+		int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			return; // EAGAIN или клиент ушел до accept
+		}
+		uint64_t id = nextConnection++;
+		std::unique_ptr<connection> c(new connection);
+		c->fd = fd;
+		epoll_event ev = {};
+		ev.events = EPOLLIN;
+		ev.data.u64 = id;
+		if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+			::close(fd);
+			continue;
+		}
+		connections[id] = std::move(c);
+		connectionCount++;
+	}
+}
+
+void cipherServer::closeConnection(uint64_t id)
+{
+	auto it = connections.find(id);
+	if (it == connections.end()) {
+		return;
+	}
+	::epoll_ctl(epollFd, EPOLL_CTL_DEL, it->second->fd, nullptr);
+	::close(it->second->fd);
+	connections.erase(it);
+}
+
+// Чтение идет, пока клиент не закрыл свою сторону и очереди соединения
+// не переполнены; EPOLLOUT нужен, только пока в out есть данные
+void cipherServer::updateConnection(uint64_t id, connection& c)
+{
+	queueRequests(id, c);
+	if (c.out.empty() && (c.closing || (c.peerClosed && c.inflight == 0))) {
+		closeConnection(id);
+		return;
+	}
+	bool full = c.inflight >= maxInflight || c.out.size() >= maxQueuedOutput;
+	bool read = !c.closing && !c.peerClosed && !full;
+	bool write = !c.out.empty();
+	if (read == c.reading && write == c.writing) {
+		return;
+	}
+	if (c.reading && !read && full) {
+		throttleCount++;
+	}
+	epoll_event ev = {};
+	if (read) {
+		ev.events |= EPOLLIN;
+	}
+	if (write) {
+		ev.events |= EPOLLOUT;
+	}
+	ev.data.u64 = id;
+	::epoll_ctl(epollFd, EPOLL_CTL_MOD, c.fd, &ev);
+	c.reading = read;
+	c.writing = write;
+}
+
+void cipherServer::readConnection(uint64_t id)
+{
+	auto it = connections.find(id);
+	if (it == connections.end()) {
+		return;
+	}
+	connection& c = *it->second;
+	if (c.closing || c.peerClosed) {
+		// EPOLLIN снят, сюда приводит только EPOLLHUP/EPOLLERR: клиент ушел совсем
+		closeConnection(id);
+		return;
+	}
+	char buffer[65536];
+	while (c.in.size() < maxBufferedInput) {
+		ssize_t n = ::recv(c.fd, buffer, sizeof(buffer), 0);
+		if (n > 0) {
+			c.in.append(buffer, n);
+			continue;
+		}
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			break;
+		}
+		if (n < 0) {
+			closeConnection(id); // ошибка сокета: ответы доставить некуда
+			return;
+		}
+		c.peerClosed = true; // конец потока: отвечаем на уже пришедшие кадры
+		break;
+	}
+	updateConnection(id, c);
+}
+
+// Разбор пришедших кадров, пока очереди соединения не переполнены
+void cipherServer::queueRequests(uint64_t id, connection& c)
+{
+	size_t offset = 0;
+	while (!c.closing && c.inflight < maxInflight && c.out.size() < maxQueuedOutput) {
+		cipherRequest r;
+		size_t length;
+		try {
+			length = decodeRequest(c.in.data() + offset, c.in.size() - offset, r);
+		} catch (const protocol_error& e) {
+			cipherReply reply;
+			reply.status = replyStatus::badRequest;
+			reply.text = e.what();
+			encodeReply(reply, c.out);
+			c.closing = true;
+			c.in.clear();
+			return;
+		}
+		if (length == 0) {
+			break;
+		}
+		offset += length;
+		if (pending.empty()) {
+			pendingSince = std::chrono::steady_clock::now();
+		}
+		batchKey key(static_cast<uint8_t>(r.kind),
+		             r.kind == cipherKind::gronsfeld ? r.key : std::string(),
+		             r.kind == cipherKind::route ? r.columns : 0);
+		pending[key].push_back(pendingRequest{id, std::move(r)});
+		c.inflight++;
+	}
+	c.in.erase(0, offset);
+}
+
+void cipherServer::writeConnection(uint64_t id)
+{
+	auto it = connections.find(id);
+	if (it == connections.end()) {
+		return;
+	}
+	connection& c = *it->second;
+	size_t sent = 0;
+	while (sent < c.out.size()) {
+		ssize_t n = ::send(c.fd, c.out.data() + sent, c.out.size() - sent, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			break;
+		}
+		if (n < 0) {
+			closeConnection(id);
+			return;
+		}
+		sent += n;
+	}
+	c.out.erase(0, sent);
+	updateConnection(id, c);
+}
+
+// Группа одного ключа уходит рабочим частями по maxBatchRequests с общим шифром
+void cipherServer::flushPending()
+{
+	{
+		std::lock_guard<std::mutex> guard(tasksLock);
+		for (auto& group : pending) {
+			auto cipher = std::make_shared<batchCipher>();
+			cipher->key = group.first;
+			std::vector<pendingRequest>& requests = group.second;
+			for (size_t begin = 0; begin < requests.size(); begin += maxBatchRequests) {
+				size_t end = std::min(requests.size(), begin + maxBatchRequests);
+				auto batch = std::make_shared<std::vector<pendingRequest>>(
+					std::make_move_iterator(requests.begin() + begin),
+					std::make_move_iterator(requests.begin() + end));
+				tasks.push_back([this, cipher, batch]() { runBatch(*cipher, *batch); });
+				batchCount++;
+			}
+		}
+	}
+	tasksReady.notify_all();
+	pending.clear();
+}
+
+void cipherServer::deliverReplies()
+{
+	std::vector<completedReply> ready;
+	{
+		std::lock_guard<std::mutex> guard(doneLock);
+		ready.swap(done);
+	}
+	std::vector<uint64_t> touched;
+	for (auto& r : ready) {
+		auto it = connections.find(r.connection);
+		if (it == connections.end()) {
+			continue;
+		}
+		it->second->out += r.frame;
+		it->second->inflight--;
+		touched.push_back(r.connection);
+	}
+	std::sort(touched.begin(), touched.end());
+	touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+	for (uint64_t id : touched) {
+		writeConnection(id);
+	}
+}
+
+// Шифр группы из кэша; исключения не выходят наружу, чтобы call_once завершился
+void cipherServer::resolveCipher(batchCipher& cipher)
+{
+	std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> codec;
+	try {
+		if (std::get<0>(cipher.key) == static_cast<uint8_t>(cipherKind::gronsfeld)) {
+			cipher.gronsfeld = cache.gronsfeld(codec.from_bytes(std::get<1>(cipher.key)));
+		} else {
+			cipher.route = cache.route(static_cast<int>(std::get<2>(cipher.key)));
+		}
+	} catch (const std::range_error&) {
+		cipher.keyError = "Invalid UTF-8 in key";
+	} catch (const std::exception& e) {
+		cipher.keyError = e.what(); // cipher_error, route_cipher_error, bad_alloc
+	}
+}
+
+// Шифр общий для всех пакетов группы; временные буферы запросов - в арене,
+// которая сбрасывается после каждого запроса. На каждый запрос пакета уходит
+// ровно один ответ: любая ошибка запроса становится ответом cipherError
+void cipherServer::runBatch(batchCipher& cipher, std::vector<pendingRequest>& batch)
+{
+	std::call_once(cipher.resolved, [this, &cipher]() { resolveCipher(cipher); });
+	std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> codec;
+	const std::shared_ptr<const modAlphaCipher>& gronsfeld = cipher.gronsfeld;
+	const std::shared_ptr<const routeCipher>& route = cipher.route;
+	const std::string& keyError = cipher.keyError;
+
+	std::vector<completedReply> replies;
+	replies.reserve(batch.size());
+	std::pmr::monotonic_buffer_resource arena;
+	for (auto& p : batch) {
+		cipherReply reply;
+		reply.id = p.request.id;
+		if (!keyError.empty()) {
+			reply.status = replyStatus::cipherError;
+			reply.text = keyError;
+		} else {
+			try {
+				std::wstring text = codec.from_bytes(p.request.text);
+				bool encrypting = p.request.op == cipherOp::encrypt;
+				std::pmr::wstring result(&arena);
+				if (gronsfeld) {
+					result = encrypting ? gronsfeld->encrypt(text, &arena) : gronsfeld->decrypt(text, &arena);
+				} else {
+					result = encrypting ? route->encrypt(text, &arena) : route->decrypt(text, &arena);
+				}
+				reply.text = codec.to_bytes(result.data(), result.data() + result.size());
+			} catch (const std::range_error&) {
+				reply.status = replyStatus::cipherError;
+				reply.text = "Invalid UTF-8 in text";
+			} catch (const std::exception& e) {
+				reply.status = replyStatus::cipherError;
+				reply.text = e.what();
+			}
+		}
+		arena.release();
+		completedReply done_reply;
+		done_reply.connection = p.connection;
+		try {
+			encodeReply(reply, done_reply.frame);
+		} catch (const std::exception& e) {
+			// Результат не помещается в кадр: клиент все равно получает ответ на свой id
+			cipherReply failure;
+			failure.id = reply.id;
+			failure.status = replyStatus::cipherError;
+			failure.text = e.what();
+			done_reply.frame.clear();
+			encodeReply(failure, done_reply.frame);
+		}
+		replies.push_back(std::move(done_reply));
+	}
+	requestCount += batch.size();
+
+	{
+		std::lock_guard<std::mutex> guard(doneLock);
+		for (auto& r : replies) {
+			done.push_back(std::move(r));
+		}
+	}
+	uint64_t one = 1;
+	ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+	(void)ignored;
+}
+
+void cipherServer::workerLoop()
+{
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> guard(tasksLock);
+			tasksReady.wait(guard, [this]() { return shuttingDown || !tasks.empty(); });
+			if (tasks.empty()) {
+				return;
+			}
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task();
+	}
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include "cipherProtocol.h"
+#include "../common/cipherCache.h"
+
+// Ошибка системного вызова при запуске сервера
+class server_error: public std::runtime_error {
+public:
+	explicit server_error (const std::string& what_arg):
+		std::runtime_error(what_arg) {}
+};
+
+struct serverStats {
+	uint64_t connections = 0; // принято соединений за все время
+	uint64_t requests = 0;    // выполнено запросов
+	uint64_t batches = 0;     // пакетов, отданных рабочим потокам
+	uint64_t throttled = 0;   // сколько раз чтение соединения приостанавливалось
+};
+
+// Демон шифрования: один поток с циклом epoll читает запросы и пишет ответы,
+// пул рабочих потоков шифрует. Запросы, пришедшие за один проход цикла
+// (или за batch_us микросекунд), группируются по шифру и ключу. Группа
+// делится на пакеты не длиннее maxBatchRequests, чтобы большая группа
+// расходилась по всем рабочим; шифр из кэша все пакеты группы получают
+// одним обращением, каждый пакет выполняется одним рабочим подряд.
+// Рабочие возвращают готовые ответы через очередь и будят цикл через eventfd.
+// Если клиент не забирает ответы или шлет запросы быстрее, чем они шифруются,
+// чтение его соединения приостанавливается, пока очередь не разойдется.
+// Клиент может закрыть свою сторону (shutdown(SHUT_WR)): ответы на все
+// полностью пришедшие запросы все равно будут отправлены.
+class cipherServer
+{
+private:
+	typedef std::tuple<uint8_t, std::string, uint32_t> batchKey; // kind, key, columns
+
+	struct connection {
+		int fd;
+		std::string in;
+		std::string out;         // ответы, не принятые сокетом
+		size_t inflight = 0;     // запросы, ответы на которые еще не в out
+		bool reading = true;     // подписаны на EPOLLIN
+		bool writing = false;    // подписаны на EPOLLOUT
+		bool closing = false;    // после отправки out соединение закрывается
+		bool peerClosed = false; // клиент закрыл свою сторону, новых запросов не будет
+	};
+
+	struct pendingRequest {
+		uint64_t connection;
+		cipherRequest request;
+	};
+
+	// Шифр группы запросов одного ключа: части группы берут его из кэша
+	// один раз на всех, первая начавшая часть - под once_flag
+	struct batchCipher {
+		batchKey key;
+		std::once_flag resolved;
+		std::shared_ptr<const modAlphaCipher> gronsfeld;
+		std::shared_ptr<const routeCipher> route;
+		std::string keyError; // ошибка ключа становится ответом на каждый запрос
+	};
+
+	struct completedReply {
+		uint64_t connection;
+		std::string frame;
+	};
+
+	std::string path;
+	int listenFd = -1;
+	int epollFd = -1;
+	int wakeFd = -1; // eventfd: готовые ответы или остановка
+	unsigned batchMicros;
+	cipherCache cache;
+
+	// Состояние цикла событий, трогает только поток run()
+	std::unordered_map<uint64_t, std::unique_ptr<connection>> connections;
+	uint64_t nextConnection = 1;
+	std::map<batchKey, std::vector<pendingRequest>> pending;
+	std::chrono::steady_clock::time_point pendingSince;
+
+	// Пул рабочих
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex tasksLock;
+	std::condition_variable tasksReady;
+	bool shuttingDown = false;
+
+	std::mutex doneLock;
+	std::vector<completedReply> done;
+
+	std::atomic<bool> stopping{false};
+	std::atomic<uint64_t> connectionCount{0};
+	std::atomic<uint64_t> requestCount{0};
+	std::atomic<uint64_t> batchCount{0};
+	std::atomic<uint64_t> throttleCount{0};
+
+	void acceptConnections();
+	void readConnection(uint64_t id);
+	void writeConnection(uint64_t id);
+	void closeConnection(uint64_t id);
+	void queueRequests(uint64_t id, connection& c);
+	void updateConnection(uint64_t id, connection& c);
+	void flushPending();
+	void deliverReplies();
+	void resolveCipher(batchCipher& cipher);
+	void runBatch(batchCipher& cipher, std::vector<pendingRequest>& batch);
+	void workerLoop();
+
+public:
+	cipherServer()=delete;
+	// workers = 0 - по числу ядер; batch_us = 0 - пакет собирается за один проход цикла
+	explicit cipherServer(const std::string& socket_path, unsigned workers = 0,
+	                      unsigned batch_us = 0, size_t cache_capacity = 64);
+	cipherServer(const cipherServer&)=delete;
+	cipherServer& operator=(const cipherServer&)=delete;
+	~cipherServer();
+
+	void run();  // цикл событий до вызова stop()
+	void stop(); // из любого потока и из обработчика сигнала
+	serverStats stats() const;
+};
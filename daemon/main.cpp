@@ -0,0 +1,45 @@
+// Демон шифрования: cipherd [сокет=/tmp/cipherd.sock] [рабочих=по числу ядер] [окно пакета, мкс=0]
+// Останавливается по SIGINT/SIGTERM, файл сокета удаляется.
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <locale>
+#include "cipherServer.h"
+
+static cipherServer* running = nullptr;
+
+static void onSignal(int)
+{
+	if (running) {
+		running->stop();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::locale::global(std::locale("ru_RU.UTF-8"));
+	const char* path = argc > 1 ? argv[1] : "/tmp/cipherd.sock";
+	unsigned workers = argc > 2 ? std::atoi(argv[2]) : 0;
+	unsigned batch_us = argc > 3 ? std::atoi(argv[3]) : 0;
+	try {
+		cipherServer server(path, workers, batch_us);
+		running = &server;
+		std::signal(SIGINT, onSignal);
+		std::signal(SIGTERM, onSignal);
+		std::printf("cipherd: %s\n", path);
+		std::fflush(stdout);
+		server.run();
+		running = nullptr;
+		serverStats s = server.stats();
+		std::printf("cipherd: соединений %llu, запросов %llu, пакетов %llu, приостановок чтения %llu\n",
+		            static_cast<unsigned long long>(s.connections),
+		            static_cast<unsigned long long>(s.requests),
+		            static_cast<unsigned long long>(s.batches),
+		            static_cast<unsigned long long>(s.throttled));
+	} catch (const std::exception& e) {
+		std::fprintf(stderr, "cipherd: %s\n", e.what());
+		return 1;
+	}
+	return 0;
+}
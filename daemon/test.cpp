@@ -0,0 +1,429 @@
+#include <chrono>
+#include <codecvt>
+#include <cstring>
+#include <iostream>
+#include <locale>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "cipherProtocol.h"
+#include "cipherServer.h"
+
+using namespace std;
+
+// ===================== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ =====================
+int total_tests = 0;
+int passed_tests = 0;
+
+void assert_true(bool condition, const string& message) {
+    total_tests++;
+    if (condition) {
+        passed_tests++;
+        cout << "✓ " << message << endl;
+    } else {
+        cout << "✗ " << message << endl;
+    }
+}
+
+void assert_exception(void (*func)(), const string& message) {
+    total_tests++;
+    try {
+        func();
+        cout << "✗ " << message << " (ожидалось исключение)" << endl;
+    } catch (const protocol_error& e) {
+        passed_tests++;
+        cout << "✓ " << message << endl;
+    } catch (...) {
+        cout << "✗ " << message << " (неожиданное исключение)" << endl;
+    }
+}
+
+void print_section(const string& section_name) {
+    cout << "\n" << string(60, '=') << endl;
+    cout << section_name << endl;
+    cout << string(60, '=') << endl;
+}
+
+string utf8(const wstring& ws) {
+    wstring_convert<codecvt_utf8<wchar_t>, wchar_t> codec;
+    return codec.to_bytes(ws);
+}
+
+cipherRequest gronsfeld_request(uint32_t id, cipherOp op, const wstring& key, const wstring& text) {
+    cipherRequest r;
+    r.id = id;
+    r.op = op;
+    r.kind = cipherKind::gronsfeld;
+    r.key = utf8(key);
+    r.text = utf8(text);
+    return r;
+}
+
+cipherRequest route_request(uint32_t id, cipherOp op, uint32_t columns, const wstring& text) {
+    cipherRequest r;
+    r.id = id;
+    r.op = op;
+    r.kind = cipherKind::route;
+    r.columns = columns;
+    r.text = utf8(text);
+    return r;
+}
+
+// Сервер в отдельном потоке на время теста
+struct testServer {
+    cipherServer server;
+    thread loop;
+    testServer(const string& path, unsigned batch_us) :
+        server(path, 2, batch_us), loop([this]() { server.run(); }) {}
+    ~testServer() {
+        server.stop();
+        loop.join();
+    }
+};
+
+string socket_path;
+string batch_socket_path;
+testServer* batching = nullptr;
+
+// ===================== ТЕСТЫ ПРОТОКОЛА =====================
+void test_protocol() {
+    print_section("ТЕСТЫ ПРОТОКОЛА");
+    
+    assert_true([]() {
+        cipherRequest r = gronsfeld_request(7, cipherOp::decrypt, L"КЛЮЧ", L"ТЕКСТ");
+        string frame;
+        encodeRequest(r, frame);
+        cipherRequest back;
+        return decodeRequest(frame.data(), frame.size(), back) == frame.size()
+            && back.id == 7 && back.op == cipherOp::decrypt && back.kind == cipherKind::gronsfeld
+            && back.key == r.key && back.text == r.text;
+    }(), "Запрос кодируется и разбирается");
+    
+    assert_true([]() {
+        cipherReply r;
+        r.id = 3;
+        r.status = replyStatus::cipherError;
+        r.text = "Empty open text";
+        string frame;
+        encodeReply(r, frame);
+        cipherReply back;
+        return decodeReply(frame.data(), frame.size(), back) == frame.size()
+            && back.id == 3 && back.status == replyStatus::cipherError && back.text == r.text;
+    }(), "Ответ кодируется и разбирается");
+    
+    assert_true([]() {
+        string frame;
+        encodeRequest(route_request(1, cipherOp::encrypt, 4, L"ПРИВЕТ"), frame);
+        cipherRequest back;
+        return decodeRequest(frame.data(), frame.size() - 1, back) == 0
+            && decodeRequest(frame.data(), 3, back) == 0;
+    }(), "Неполный кадр ждет данных");
+    
+    assert_exception([]() {
+        string frame("\xff\xff\xff\x7f", 4);
+        cipherRequest r;
+        decodeRequest(frame.data(), frame.size(), r);
+    }, "Слишком большой кадр");
+    
+    assert_exception([]() {
+        string frame;
+        encodeRequest(route_request(1, cipherOp::encrypt, 4, L"ПРИВЕТ"), frame);
+        frame[9] = 9;
+        cipherRequest r;
+        decodeRequest(frame.data(), frame.size(), r);
+    }, "Неизвестный шифр");
+}
+
+// ===================== ТЕСТЫ СЕРВЕРА =====================
+void test_server() {
+    print_section("ТЕСТЫ СЕРВЕРА");
+    
+    assert_true([]() {
+        cipherClient client(socket_path);
+        cipherReply r = client.call(gronsfeld_request(1, cipherOp::encrypt, L"КЛЮЧ", L"при вет"));
+        return r.id == 1 && r.status == replyStatus::ok
+            && r.text == utf8(modAlphaCipher(L"КЛЮЧ").encrypt(L"ПРИВЕТ"));
+    }(), "Шифрование Гронсфельда совпадает с modAlphaCipher");
+    
+    assert_true([]() {
+        cipherClient client(socket_path);
+        cipherReply enc = client.call(route_request(2, cipherOp::encrypt, 3, L"ПРИВЕТМИР"));
+        cipherRequest back = route_request(3, cipherOp::decrypt, 3, L"");
+        back.text = enc.text;
+        cipherReply dec = client.call(back);
+        return enc.text == utf8(routeCipher(3).encrypt(L"ПРИВЕТМИР")) && dec.text == utf8(L"ПРИВЕТМИР");
+    }(), "Маршрутная перестановка туда и обратно");
+    
+    assert_true([]() {
+        cipherClient client(socket_path);
+        cipherReply r = client.call(gronsfeld_request(4, cipherOp::decrypt, L"КЛЮЧ", L"ШИФР1"));
+        return r.status == replyStatus::cipherError && r.text.find("Invalid text") == 0;
+    }(), "Ошибка шифра возвращается в ответе");
+    
+    assert_true([]() {
+        cipherClient client(socket_path);
+        cipherReply bad = client.call(gronsfeld_request(5, cipherOp::encrypt, L"КЛЮЧ1", L"ТЕКСТ"));
+        cipherReply route = client.call(route_request(6, cipherOp::encrypt, 0, L"ТЕКСТ"));
+        cipherReply good = client.call(gronsfeld_request(7, cipherOp::encrypt, L"КЛЮЧ", L"ТЕКСТ"));
+        return bad.status == replyStatus::cipherError && route.status == replyStatus::cipherError
+            && good.status == replyStatus::ok;
+    }(), "Неверный ключ не ломает соединение");
+
+    // Строчная ɐ (2 байта) в верхнем регистре - Ɐ (3 байта): ответ длиннее кадра
+    assert_true([]() {
+        cipherClient client(socket_path);
+        cipherReply big = client.call(route_request(8, cipherOp::encrypt, 100, wstring(6000000, L'ɐ')));
+        cipherReply next = client.call(route_request(9, cipherOp::encrypt, 3, L"ПРИВЕТМИР"));
+        return big.id == 8 && big.status == replyStatus::cipherError && big.text == "Frame is too large"
+            && next.id == 9 && next.status == replyStatus::ok;
+    }(), "Слишком длинный результат - ответ с ошибкой");
+    
+    // Запросы отправлены пачкой, ответы сопоставляются по id
+    assert_true([]() {
+        cipherClient client(socket_path);
+        const int count = 200;
+        for (int i = 0; i < count; i++) {
+            if (i % 2) {
+                client.send(route_request(i, cipherOp::encrypt, 2 + i % 5, L"МАРШРУТНАЯПЕРЕСТАНОВКА"));
+            } else {
+                client.send(gronsfeld_request(i, cipherOp::encrypt, i % 4 ? L"КЛЮЧ" : L"ДРУГОЙ", L"ГРОНСФЕЛЬД"));
+            }
+        }
+        vector<bool> seen(count, false);
+        for (int i = 0; i < count; i++) {
+            cipherReply r = client.receive();
+            if (r.id >= count || seen[r.id] || r.status != replyStatus::ok) {
+                return false;
+            }
+            seen[r.id] = true;
+            string expected = r.id % 2
+                ? utf8(routeCipher(2 + r.id % 5).encrypt(L"МАРШРУТНАЯПЕРЕСТАНОВКА"))
+                : utf8(modAlphaCipher(r.id % 4 ? L"КЛЮЧ" : L"ДРУГОЙ").encrypt(L"ГРОНСФЕЛЬД"));
+            if (r.text != expected) {
+                return false;
+            }
+        }
+        return true;
+    }(), "Конвейер запросов с разными ключами");
+    
+    assert_true([]() {
+        vector<thread> clients;
+        vector<int> ok(8, 0);
+        for (int t = 0; t < 8; t++) {
+            clients.emplace_back([t, &ok]() {
+                cipherClient client(socket_path);
+                for (int i = 0; i < 50; i++) {
+                    cipherReply r = client.call(route_request(i, cipherOp::encrypt, 1 + t, L"ПАРАЛЛЕЛЬНЫЕКЛИЕНТЫ"));
+                    ok[t] += r.id == uint32_t(i) && r.text == utf8(routeCipher(1 + t).encrypt(L"ПАРАЛЛЕЛЬНЫЕКЛИЕНТЫ"));
+                }
+            });
+        }
+        for (auto& c : clients) {
+            c.join();
+        }
+        for (int n : ok) {
+            if (n != 50) {
+                return false;
+            }
+        }
+        return true;
+    }(), "Несколько клиентов одновременно");
+    
+    // Испорченный кадр: ответ badRequest, затем сервер закрывает соединение
+    assert_true([]() {
+        cipherClient client(socket_path);
+        string frame;
+        encodeRequest(route_request(1, cipherOp::encrypt, 4, L"ПРИВЕТ"), frame);
+        frame[8] = 7;
+        client.sendRaw(frame);
+        cipherReply r = client.receive();
+        try {
+            client.receive();
+        } catch (const runtime_error&) {
+            return r.status == replyStatus::badRequest;
+        }
+        return false;
+    }(), "Испорченный кадр закрывает соединение");
+    
+    // Клиент закрыл отправку: ответы на все пришедшие запросы доставляются
+    assert_true([]() {
+        cipherClient client(socket_path);
+        string frames;
+        for (int i = 0; i < 100; i++) {
+            encodeRequest(route_request(i, cipherOp::encrypt, 1 + i % 7, L"ЗАКРЫТИЕОТПРАВКИ"), frames);
+        }
+        string partial;
+        encodeRequest(route_request(100, cipherOp::encrypt, 3, L"НЕДОШЕЛ"), partial);
+        client.sendRaw(frames + partial.substr(0, partial.size() / 2));
+        client.shutdownWrite();
+        vector<bool> seen(100, false);
+        for (int i = 0; i < 100; i++) {
+            cipherReply r = client.receive();
+            if (r.id >= 100 || seen[r.id] || r.status != replyStatus::ok) {
+                return false;
+            }
+            seen[r.id] = true;
+        }
+        try {
+            client.receive();
+        } catch (const runtime_error&) {
+            return true; // недошедший кадр отброшен, соединение закрыто
+        }
+        return false;
+    }(), "Ответы после shutdown(SHUT_WR)");
+    
+    // Клиент не читает ответы: сервер перестает читать запросы, но ничего не теряет
+    assert_true([]() {
+        serverStats before = batching->server.stats();
+        cipherClient client(batch_socket_path);
+        const int count = 3000;
+        const wstring text(2000, L'Ж');
+        thread sender([&client, &text]() {
+            for (int i = 0; i < count; i++) {
+                client.send(route_request(i, cipherOp::encrypt, 1, text));
+            }
+        });
+        this_thread::sleep_for(chrono::milliseconds(300));
+        int ok = 0;
+        for (int i = 0; i < count; i++) {
+            cipherReply r = client.receive();
+            ok += r.status == replyStatus::ok && r.text.size() == 4000;
+        }
+        sender.join();
+        serverStats after = batching->server.stats();
+        return ok == count && after.throttled > before.throttled;
+    }(), "Чтение приостанавливается, пока клиент не заберет ответы");
+    
+    // Второй сервер на сокете работающего не отнимает его
+    assert_true([]() {
+        try {
+            cipherServer second(socket_path, 1);
+            return false;
+        } catch (const server_error&) {
+        }
+        cipherClient client(socket_path);
+        return client.call(route_request(1, cipherOp::encrypt, 2, L"ЖИВ")).status == replyStatus::ok;
+    }(), "Сокет работающего сервера не перехватывается");
+    
+    // Сокет без слушателя, оставшийся от упавшего процесса, заменяется
+    assert_true([]() {
+        string stale = socket_path + ".stale";
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        memcpy(addr.sun_path, stale.c_str(), stale.size() + 1);
+        bool bound = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        ::close(fd);
+        try {
+            cipherServer replacement(stale, 1);
+            return bound;
+        } catch (const server_error&) {
+            ::unlink(stale.c_str());
+            return false;
+        }
+    }(), "Оставшийся сокет без слушателя заменяется");
+}
+
+// ===================== ТЕСТЫ ПАКЕТОВ =====================
+void test_batching() {
+    print_section("ТЕСТЫ ПАКЕТОВ");
+    
+    // Окно пакета 20 мс: запросы одной пачки с одним ключом - один пакет
+    assert_true([]() {
+        serverStats before = batching->server.stats();
+        cipherClient client(batch_socket_path);
+        string frames;
+        for (int i = 0; i < 64; i++) {
+            encodeRequest(gronsfeld_request(i, cipherOp::encrypt, L"ПАКЕТ", L"ОДИНКЛЮЧ"), frames);
+        }
+        client.sendRaw(frames);
+        for (int i = 0; i < 64; i++) {
+            if (client.receive().status != replyStatus::ok) {
+                return false;
+            }
+        }
+        serverStats after = batching->server.stats();
+        return after.requests - before.requests == 64 && after.batches - before.batches <= 2;
+    }(), "Запросы с одним ключом собираются в пакет");
+    
+    assert_true([]() {
+        serverStats before = batching->server.stats();
+        cipherClient client(batch_socket_path);
+        string frames;
+        for (int i = 0; i < 30; i++) {
+            encodeRequest(route_request(i, cipherOp::encrypt, 1 + i % 3, L"ТРИКЛЮЧА"), frames);
+        }
+        client.sendRaw(frames);
+        for (int i = 0; i < 30; i++) {
+            client.receive();
+        }
+        serverStats after = batching->server.stats();
+        return after.batches - before.batches >= 3 && after.batches - before.batches <= 6;
+    }(), "Разные ключи - разные пакеты");
+    
+    // Большая группа одного ключа делится на пакеты по 64 запроса
+    assert_true([]() {
+        serverStats before = batching->server.stats();
+        cipherClient client(batch_socket_path);
+        string frames;
+        for (int i = 0; i < 256; i++) {
+            encodeRequest(gronsfeld_request(i, cipherOp::encrypt, L"ПАКЕТ", L"БОЛЬШАЯГРУППА"), frames);
+        }
+        client.sendRaw(frames);
+        vector<bool> seen(256, false);
+        for (int i = 0; i < 256; i++) {
+            cipherReply r = client.receive();
+            if (r.id >= 256 || seen[r.id] || r.status != replyStatus::ok) {
+                return false;
+            }
+            seen[r.id] = true;
+        }
+        serverStats after = batching->server.stats();
+        return after.requests - before.requests == 256 && after.batches - before.batches >= 4;
+    }(), "Большая группа делится на пакеты");
+}
+
+// ===================== ОСНОВНАЯ ФУНКЦИЯ =====================
+int main() {
+    locale::global(locale("ru_RU.UTF-8"));
+
+    cout << "\n" << string(70, '=') << endl;
+    cout << "МОДУЛЬНОЕ ТЕСТИРОВАНИЕ ДЕМОНА ШИФРОВАНИЯ" << endl;
+    cout << string(70, '=') << endl;
+
+    // Два сервера: без окна пакета и с окном 20 мс
+    socket_path = "/tmp/cipherd_test_" + to_string(getpid()) + ".sock";
+    batch_socket_path = "/tmp/cipherd_batch_" + to_string(getpid()) + ".sock";
+    {
+        testServer plain(socket_path, 0);
+        testServer window(batch_socket_path, 20000);
+        batching = &window;
+
+        // Запуск всех тестов
+        test_protocol();
+        test_server();
+        test_batching();
+        batching = nullptr;
+    }
+
+    // Итоги
+    cout << "\n" << string(70, '=') << endl;
+    cout << "ИТОГИ ТЕСТИРОВАНИЯ" << endl;
+    cout << string(70, '=') << endl;
+
+    cout << "Всего тестов: " << total_tests << endl;
+    cout << "Пройдено: " << passed_tests << endl;
+    cout << "Не пройдено: " << (total_tests - passed_tests) << endl;
+
+    if (passed_tests == total_tests) {
+        cout << "\n✓ ВСЕ ТЕСТЫ УСПЕШНО ПРОЙДЕНЫ!" << endl;
+        return 0;
+    } else {
+        cout << "\n✗ ТЕСТИРОВАНИЕ НЕ УСПЕШНО" << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef CIPHER_H
+#define CIPHER_H
+
+/* C-интерфейс libcipher: modAlphaCipher (Гронсфельд) и routeCipher.
+ *
+ * Шифр - непрозрачный дескриптор, неизменяемый после создания: один дескриптор
+ * можно использовать из нескольких потоков. Вход - буфер вызывающего в UTF-8
+ * или UTF-32 с явной длиной (в байтах или кодовых точках, без завершающего
+ * нуля), результат пишется в буфер вызывающего емкостью out_cap тех же единиц.
+ * Вход UTF-32 читается на месте, временные буферы берутся из арены потока,
+ * результат кодируется сразу в выходной буфер.
+ *
+ * Для русского текста результат не длиннее входа, поэтому out_cap = in_len
+ * достаточно. Если буфер мал, возвращается CIPHER_BUFFER_TOO_SMALL, а в
+ * *out_len - нужный размер. При ошибке входа в *out_len - позиция ошибочного
+ * символа во входе (в тех же единицах).
+ *
+ * modAlphaCipher определяет буквы по локали C: вызывающий должен установить
+ * LC_CTYPE с кириллицей, например setlocale(LC_ALL, "ru_RU.UTF-8").
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define CIPHER_API __attribute__((visibility("default")))
+#else
+#define CIPHER_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct cipher_handle cipher_handle;
+
+typedef enum cipher_status {
+	CIPHER_OK = 0,
+	CIPHER_EMPTY_TEXT,        /* пустой вход или открытый текст без букв */
+	CIPHER_INVALID_TEXT,      /* в шифротексте не заглавная буква */
+	CIPHER_OUT_OF_ALPHABET,   /* буква не из русского алфавита */
+	CIPHER_INVALID_KEY,       /* пустой или недопустимый ключ, неверное число столбцов */
+	CIPHER_INVALID_ENCODING,  /* испорченный UTF-8 или недопустимая кодовая точка */
+	CIPHER_BUFFER_TOO_SMALL,
+	CIPHER_INVALID_ARGUMENT,  /* нулевой указатель */
+	CIPHER_NO_MEMORY,
+	CIPHER_INTERNAL_ERROR     /* непредвиденное исключение внутри библиотеки */
+} cipher_status;
+
+CIPHER_API const char* cipher_status_message(cipher_status status);
+
+/* Создание и освобождение дескрипторов. Ключ с ошибкой кодировки -
+ * CIPHER_INVALID_ENCODING, недопустимый ключ - CIPHER_INVALID_KEY */
+CIPHER_API cipher_status cipher_gronsfeld_new(const char* key_utf8, size_t key_len, cipher_handle** out);
+CIPHER_API cipher_status cipher_gronsfeld_new_utf32(const uint32_t* key, size_t key_len, cipher_handle** out);
+CIPHER_API cipher_status cipher_route_new(int columns, cipher_handle** out);
+CIPHER_API void cipher_free(cipher_handle* cipher);
+
+/* UTF-8: длины в байтах */
+CIPHER_API cipher_status cipher_encrypt_utf8(const cipher_handle* cipher, const char* in, size_t in_len,
+                                             char* out, size_t out_cap, size_t* out_len);
+CIPHER_API cipher_status cipher_decrypt_utf8(const cipher_handle* cipher, const char* in, size_t in_len,
+                                             char* out, size_t out_cap, size_t* out_len);
+
+/* UTF-32 в порядке байтов платформы: длины в кодовых точках */
+CIPHER_API cipher_status cipher_encrypt_utf32(const cipher_handle* cipher, const uint32_t* in, size_t in_len,
+                                              uint32_t* out, size_t out_cap, size_t* out_len);
+CIPHER_API cipher_status cipher_decrypt_utf32(const cipher_handle* cipher, const uint32_t* in, size_t in_len,
+                                              uint32_t* out, size_t out_cap, size_t* out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
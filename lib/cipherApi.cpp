@@ -0,0 +1,385 @@
+#include "cipher.h"
+#include "../task1/modAlphaCipher.h"
+#include "../task2/routeCipher.h"
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Вход UTF-32 и ключ копируются в wchar_t через memcpy: читать буфер uint32_t
+// как wchar_t на месте нельзя по правилам алиасинга, а копия в арене потока
+// стоит одного memcpy без обращения к куче.
+static_assert(sizeof(wchar_t) == sizeof(uint32_t), "UTF-32 code points are copied as wchar_t");
+
+struct cipher_handle {
+	std::optional<modAlphaCipher> gronsfeld;
+	std::optional<routeCipher> route;
+};
+
+namespace {
+
+// Арена потока: временные буферы одного вызова, сбрасывается после него.
+// Буфер выделяется при первом вызове в потоке, большие тексты уходят в кучу.
+struct threadArena {
+	std::vector<char> buffer = std::vector<char>(64 * 1024);
+	std::pmr::monotonic_buffer_resource resource{buffer.data(), buffer.size()};
+};
+
+class arenaScope
+{
+private:
+	threadArena& arena;
+public:
+	arenaScope() : arena(current()) {}
+	~arenaScope() { arena.resource.release(); }
+	std::pmr::memory_resource* resource() { return &arena.resource; }
+	static threadArena& current()
+	{
+		thread_local threadArena arena;
+		return arena;
+	}
+};
+
+bool validCodePoint(uint32_t c)
+{
+	return c <= 0x10FFFF && (c < 0xD800 || c > 0xDFFF);
+}
+
+// Строгий разбор UTF-8: без сокращенных форм и суррогатов.
+// При ошибке pos - байт, с которого начинается испорченная последовательность.
+bool decodeUtf8(const char* in, size_t len, std::pmr::wstring& out, size_t& pos)
+{
+	out.reserve(len);
+	size_t i = 0;
+	while (i < len) {
+		unsigned char b = in[i];
+		uint32_t c;
+		size_t extra;
+		uint32_t min;
+		if (b < 0x80) {
+			out.push_back(static_cast<wchar_t>(b));
+			i++;
+			continue;
+		} else if ((b & 0xE0) == 0xC0) {
+			c = b & 0x1F;
+			extra = 1;
+			min = 0x80;
+		} else if ((b & 0xF0) == 0xE0) {
+			c = b & 0x0F;
+			extra = 2;
+			min = 0x800;
+		} else if ((b & 0xF8) == 0xF0) {
+			c = b & 0x07;
+			extra = 3;
+			min = 0x10000;
+		} else {
+			pos = i;
+			return false;
+		}
+		if (len - i <= extra) {
+			pos = i;
+			return false;
+		}
+		for (size_t k = 1; k <= extra; k++) {
+			unsigned char cont = in[i + k];
+			if ((cont & 0xC0) != 0x80) {
+				pos = i;
+				return false;
+			}
+			c = (c << 6) | (cont & 0x3F);
+		}
+		if (c < min || !validCodePoint(c)) {
+			pos = i;
+			return false;
+		}
+		out.push_back(static_cast<wchar_t>(c));
+		i += extra + 1;
+	}
+	return true;
+}
+
+size_t utf8Length(uint32_t c)
+{
+	return c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+}
+
+// Байтовое смещение кодовой точки index в корректном UTF-8
+size_t utf8Offset(const char* in, size_t len, size_t index)
+{
+	size_t i = 0;
+	for (size_t n = 0; n < index && i < len; n++) {
+		unsigned char b = in[i];
+		i += b < 0x80 ? 1 : (b & 0xE0) == 0xC0 ? 2 : (b & 0xF0) == 0xE0 ? 3 : 4;
+	}
+	return i < len ? i : len;
+}
+
+cipher_status toStatus(cipherStatus s)
+{
+	switch (s) {
+	case cipherStatus::ok:
+		return CIPHER_OK;
+	case cipherStatus::emptyText:
+		return CIPHER_EMPTY_TEXT;
+	case cipherStatus::invalidText:
+		return CIPHER_INVALID_TEXT;
+	case cipherStatus::outOfAlphabet:
+		return CIPHER_OUT_OF_ALPHABET;
+	}
+	return CIPHER_INVALID_TEXT;
+}
+
+cipher_status toStatus(routeStatus s)
+{
+	switch (s) {
+	case routeStatus::ok:
+		return CIPHER_OK;
+	case routeStatus::emptyText:
+	case routeStatus::noLetters:
+		return CIPHER_EMPTY_TEXT;
+	case routeStatus::notLetter:
+	case routeStatus::notUppercase:
+		return CIPHER_INVALID_TEXT;
+	}
+	return CIPHER_INVALID_TEXT;
+}
+
+cipher_status transform(const cipher_handle* c, std::wstring_view text, bool encrypting,
+                        std::pmr::wstring& out, size_t& pos)
+{
+	if (c->gronsfeld) {
+		return toStatus(encrypting ? c->gronsfeld->tryEncrypt(text, out, pos)
+		                           : c->gronsfeld->tryDecrypt(text, out, pos));
+	}
+	return toStatus(encrypting ? c->route->tryEncrypt(text, out, pos)
+	                           : c->route->tryDecrypt(text, out, pos));
+}
+
+cipher_status runUtf8(const cipher_handle* c, const char* in, size_t in_len,
+                      char* out, size_t out_cap, size_t* out_len, bool encrypting)
+{
+	if (!c || !out_len || (!in && in_len) || (!out && out_cap)) {
+		return CIPHER_INVALID_ARGUMENT;
+	}
+	arenaScope scope;
+	std::pmr::wstring text(scope.resource());
+	size_t pos = 0;
+	if (!decodeUtf8(in, in_len, text, pos)) {
+		*out_len = pos;
+		return CIPHER_INVALID_ENCODING;
+	}
+	std::pmr::wstring result(scope.resource());
+	cipher_status status = transform(c, text, encrypting, result, pos);
+	if (status != CIPHER_OK) {
+		*out_len = utf8Offset(in, in_len, pos);
+		return status;
+	}
+
+	size_t needed = 0;
+	for (wchar_t wc : result) {
+		needed += utf8Length(static_cast<uint32_t>(wc));
+	}
+	*out_len = needed;
+	if (needed > out_cap) {
+		return CIPHER_BUFFER_TOO_SMALL;
+	}
+	for (wchar_t wc : result) {
+		uint32_t ch = static_cast<uint32_t>(wc);
+		if (ch < 0x80) {
+			*out++ = static_cast<char>(ch);
+		} else if (ch < 0x800) {
+			*out++ = static_cast<char>(0xC0 | (ch >> 6));
+			*out++ = static_cast<char>(0x80 | (ch & 0x3F));
+		} else if (ch < 0x10000) {
+			*out++ = static_cast<char>(0xE0 | (ch >> 12));
+			*out++ = static_cast<char>(0x80 | ((ch >> 6) & 0x3F));
+			*out++ = static_cast<char>(0x80 | (ch & 0x3F));
+		} else {
+			*out++ = static_cast<char>(0xF0 | (ch >> 18));
+			*out++ = static_cast<char>(0x80 | ((ch >> 12) & 0x3F));
+			*out++ = static_cast<char>(0x80 | ((ch >> 6) & 0x3F));
+			*out++ = static_cast<char>(0x80 | (ch & 0x3F));
+		}
+	}
+	return CIPHER_OK;
+}
+
+cipher_status runUtf32(const cipher_handle* c, const uint32_t* in, size_t in_len,
+                       uint32_t* out, size_t out_cap, size_t* out_len, bool encrypting)
+{
+	if (!c || !out_len || (!in && in_len) || (!out && out_cap)) {
+		return CIPHER_INVALID_ARGUMENT;
+	}
+	for (size_t i = 0; i < in_len; i++) {
+		if (!validCodePoint(in[i])) {
+			*out_len = i;
+			return CIPHER_INVALID_ENCODING;
+		}
+	}
+	arenaScope scope;
+	std::pmr::wstring text(in_len, L'\0', scope.resource());
+	if (in_len) {
+		std::memcpy(&text[0], in, in_len * sizeof(uint32_t));
+	}
+	std::pmr::wstring result(scope.resource());
+	size_t pos = 0;
+	cipher_status status = transform(c, text, encrypting, result, pos);
+	if (status != CIPHER_OK) {
+		*out_len = pos;
+		return status;
+	}
+	*out_len = result.size();
+	if (result.size() > out_cap) {
+		return CIPHER_BUFFER_TOO_SMALL;
+	}
+	for (wchar_t wc : result) {
+		*out++ = static_cast<uint32_t>(wc);
+	}
+	return CIPHER_OK;
+}
+
+template <class Make>
+cipher_status create(cipher_handle** out, Make make)
+{
+	if (!out) {
+		return CIPHER_INVALID_ARGUMENT;
+	}
+	*out = nullptr;
+	try {
+		std::unique_ptr<cipher_handle> handle(new cipher_handle);
+		make(*handle);
+		*out = handle.release();
+		return CIPHER_OK;
+	} catch (const std::bad_alloc&) {
+		return CIPHER_NO_MEMORY;
+	} catch (const cipher_error&) {
+		return CIPHER_INVALID_KEY;
+	} catch (const route_cipher_error&) {
+		return CIPHER_INVALID_KEY;
+	} catch (...) {
+		return CIPHER_INTERNAL_ERROR;
+	}
+}
+
+template <class Body>
+cipher_status guarded(Body body)
+{
+	try {
+		return body();
+	} catch (const std::bad_alloc&) {
+		return CIPHER_NO_MEMORY;
+	} catch (...) {
+		return CIPHER_INTERNAL_ERROR; // ошибки входа возвращаются статусом и сюда не доходят
+	}
+}
+
+}
+
+extern "C" {
+
+const char* cipher_status_message(cipher_status status)
+{
+	switch (status) {
+	case CIPHER_OK:
+		return "Ok";
+	case CIPHER_EMPTY_TEXT:
+		return "Empty text";
+	case CIPHER_INVALID_TEXT:
+		return "Invalid text";
+	case CIPHER_OUT_OF_ALPHABET:
+		return "Symbol out of alphabet";
+	case CIPHER_INVALID_KEY:
+		return "Invalid key";
+	case CIPHER_INVALID_ENCODING:
+		return "Invalid encoding";
+	case CIPHER_BUFFER_TOO_SMALL:
+		return "Output buffer is too small";
+	case CIPHER_INVALID_ARGUMENT:
+		return "Invalid argument";
+	case CIPHER_NO_MEMORY:
+		return "Out of memory";
+	case CIPHER_INTERNAL_ERROR:
+		return "Internal error";
+	}
+	return "Unknown error";
+}
+
+cipher_status cipher_gronsfeld_new(const char* key_utf8, size_t key_len, cipher_handle** out)
+{
+	if (!out || (!key_utf8 && key_len)) {
+		return CIPHER_INVALID_ARGUMENT;
+	}
+	*out = nullptr;
+	return guarded([&]() {
+		arenaScope scope;
+		std::pmr::wstring key(scope.resource());
+		size_t pos = 0;
+		if (!decodeUtf8(key_utf8, key_len, key, pos)) {
+			return CIPHER_INVALID_ENCODING;
+		}
+		return create(out, [&](cipher_handle& h) {
+			h.gronsfeld.emplace(std::wstring(key.data(), key.size()));
+		});
+	});
+}
+
+cipher_status cipher_gronsfeld_new_utf32(const uint32_t* key, size_t key_len, cipher_handle** out)
+{
+	if (!out || (!key && key_len)) {
+		return CIPHER_INVALID_ARGUMENT;
+	}
+	*out = nullptr;
+	for (size_t i = 0; i < key_len; i++) {
+		if (!validCodePoint(key[i])) {
+			return CIPHER_INVALID_ENCODING;
+		}
+	}
+	return create(out, [&](cipher_handle& h) {
+		std::wstring text(key_len, L'\0');
+		if (key_len) {
+			std::memcpy(&text[0], key, key_len * sizeof(uint32_t));
+		}
+		h.gronsfeld.emplace(text);
+	});
+}
+
+cipher_status cipher_route_new(int columns, cipher_handle** out)
+{
+	return create(out, [&](cipher_handle& h) {
+		h.route.emplace(columns);
+	});
+}
+
+void cipher_free(cipher_handle* cipher)
+{
+	delete cipher;
+}
+
+cipher_status cipher_encrypt_utf8(const cipher_handle* cipher, const char* in, size_t in_len,
+                                  char* out, size_t out_cap, size_t* out_len)
+{
+	return guarded([&]() { return runUtf8(cipher, in, in_len, out, out_cap, out_len, true); });
+}
+
+cipher_status cipher_decrypt_utf8(const cipher_handle* cipher, const char* in, size_t in_len,
+                                  char* out, size_t out_cap, size_t* out_len)
+{
+	return guarded([&]() { return runUtf8(cipher, in, in_len, out, out_cap, out_len, false); });
+}
+
+cipher_status cipher_encrypt_utf32(const cipher_handle* cipher, const uint32_t* in, size_t in_len,
+                                   uint32_t* out, size_t out_cap, size_t* out_len)
+{
+	return guarded([&]() { return runUtf32(cipher, in, in_len, out, out_cap, out_len, true); });
+}
+
+cipher_status cipher_decrypt_utf32(const cipher_handle* cipher, const uint32_t* in, size_t in_len,
+                                   uint32_t* out, size_t out_cap, size_t* out_len)
+{
+	return guarded([&]() { return runUtf32(cipher, in, in_len, out, out_cap, out_len, false); });
+}
+
+}
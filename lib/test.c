@@ -0,0 +1,223 @@
+/* Тесты C-интерфейса libcipher: собираются компилятором C и линкуются с libcipher.so */
+#include <locale.h>
+#include <stdio.h>
+#include <string.h>
+#include "cipher.h"
+
+/* ===================== ВСПОМОГАТЕЛЬНЫЕ ФУНКЦИИ ===================== */
+static int total_tests = 0;
+static int passed_tests = 0;
+
+static void assert_true(int condition, const char* message)
+{
+    total_tests++;
+    if (condition) {
+        passed_tests++;
+        printf("✓ %s\n", message);
+    } else {
+        printf("✗ %s\n", message);
+    }
+}
+
+static void print_section(const char* section_name)
+{
+    printf("\n============================================================\n");
+    printf("%s\n", section_name);
+    printf("============================================================\n");
+}
+
+/* Результат UTF-8 совпадает с ожидаемой строкой */
+static int same(const char* out, size_t out_len, const char* expected)
+{
+    return out_len == strlen(expected) && memcmp(out, expected, out_len) == 0;
+}
+
+/* ===================== ТЕСТЫ UTF-8 ===================== */
+static int gronsfeld_round_trip(void)
+{
+    cipher_handle* c;
+    char enc[64], dec[64];
+    size_t enc_len, dec_len;
+    const char* key = "КЛЮЧ";
+    const char* text = "при вет, мир!";
+    int ok = cipher_gronsfeld_new(key, strlen(key), &c) == CIPHER_OK
+        && cipher_encrypt_utf8(c, text, strlen(text), enc, sizeof(enc), &enc_len) == CIPHER_OK
+        && cipher_decrypt_utf8(c, enc, enc_len, dec, sizeof(dec), &dec_len) == CIPHER_OK
+        && same(dec, dec_len, "ПРИВЕТМИР") && !same(enc, enc_len, "ПРИВЕТМИР");
+    cipher_free(c);
+    return ok;
+}
+
+static int route_known_answer(void)
+{
+    cipher_handle* c;
+    char enc[64], dec[64];
+    size_t enc_len, dec_len;
+    const char* text = "ПРИВЕТМИР";
+    int ok = cipher_route_new(4, &c) == CIPHER_OK
+        && cipher_encrypt_utf8(c, text, strlen(text), enc, sizeof(enc), &enc_len) == CIPHER_OK
+        && same(enc, enc_len, "ВИИМРТПЕР")
+        && cipher_decrypt_utf8(c, enc, enc_len, dec, sizeof(dec), &dec_len) == CIPHER_OK
+        && same(dec, dec_len, text);
+    cipher_free(c);
+    return ok;
+}
+
+static int buffer_too_small(void)
+{
+    cipher_handle* c;
+    char out[4];
+    size_t out_len = 0;
+    const char* text = "ПРИВЕТ";
+    int ok = cipher_route_new(2, &c) == CIPHER_OK
+        && cipher_encrypt_utf8(c, text, strlen(text), out, sizeof(out), &out_len) == CIPHER_BUFFER_TOO_SMALL
+        && out_len == strlen(text);
+    cipher_free(c);
+    return ok;
+}
+
+static int error_position(void)
+{
+    cipher_handle* c;
+    char out[64];
+    size_t pos = 0;
+    const char* text = "ШИФР1";
+    int ok = cipher_gronsfeld_new("КЛЮЧ", strlen("КЛЮЧ"), &c) == CIPHER_OK
+        && cipher_decrypt_utf8(c, text, strlen(text), out, sizeof(out), &pos) == CIPHER_INVALID_TEXT
+        && pos == 8; /* четыре буквы по два байта */
+    cipher_free(c);
+    return ok;
+}
+
+static int invalid_utf8(void)
+{
+    cipher_handle* c;
+    char out[64];
+    size_t pos = 0;
+    const char text[] = {'\xd0', '\x9f', '\xd0'}; /* "П" и обрезанная вторая буква */
+    const char overlong[] = {'\xc0', '\xaf'};
+    int ok = cipher_route_new(3, &c) == CIPHER_OK
+        && cipher_encrypt_utf8(c, text, sizeof(text), out, sizeof(out), &pos) == CIPHER_INVALID_ENCODING
+        && pos == 2
+        && cipher_encrypt_utf8(c, overlong, sizeof(overlong), out, sizeof(out), &pos) == CIPHER_INVALID_ENCODING;
+    cipher_free(c);
+    return ok;
+}
+
+static void test_utf8(void)
+{
+    print_section("ТЕСТЫ UTF-8");
+    assert_true(gronsfeld_round_trip(), "Гронсфельд: шифрование и расшифрование");
+    assert_true(route_known_answer(), "Маршрут: известный шифротекст");
+    assert_true(buffer_too_small(), "Малый буфер: нужный размер в out_len");
+    assert_true(error_position(), "Позиция ошибки в байтах");
+    assert_true(invalid_utf8(), "Испорченный UTF-8");
+}
+
+/* ===================== ТЕСТЫ UTF-32 ===================== */
+/* Кириллица в UTF-8 - по два байта на букву */
+static size_t cyrillic_to_utf32(const char* in, size_t len, uint32_t* out)
+{
+    size_t n = 0;
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        out[n++] = (((uint32_t)(unsigned char)in[i] & 0x1F) << 6) | ((unsigned char)in[i + 1] & 0x3F);
+    }
+    return n;
+}
+
+static int utf32_matches_utf8(void)
+{
+    cipher_handle* c;
+    const uint32_t text[] = {0x41F, 0x420, 0x418, 0x412, 0x415, 0x422}; /* ПРИВЕТ */
+    uint32_t enc[6], dec[6], expected[6];
+    char enc8[32];
+    size_t enc_len, dec_len, enc8_len;
+    int ok = cipher_gronsfeld_new("КЛЮЧ", strlen("КЛЮЧ"), &c) == CIPHER_OK
+        && cipher_encrypt_utf32(c, text, 6, enc, 6, &enc_len) == CIPHER_OK
+        && cipher_encrypt_utf8(c, "ПРИВЕТ", strlen("ПРИВЕТ"), enc8, sizeof(enc8), &enc8_len) == CIPHER_OK
+        && cipher_decrypt_utf32(c, enc, enc_len, dec, 6, &dec_len) == CIPHER_OK
+        && enc_len == 6 && dec_len == 6 && memcmp(dec, text, sizeof(text)) == 0
+        && cyrillic_to_utf32(enc8, enc8_len, expected) == 6
+        && memcmp(enc, expected, sizeof(expected)) == 0;
+    cipher_free(c);
+    return ok;
+}
+
+static int utf32_invalid_code_point(void)
+{
+    cipher_handle* c;
+    const uint32_t text[] = {0x41F, 0xD800};
+    uint32_t out[2];
+    size_t pos = 0;
+    int ok = cipher_route_new(2, &c) == CIPHER_OK
+        && cipher_encrypt_utf32(c, text, 2, out, 2, &pos) == CIPHER_INVALID_ENCODING && pos == 1;
+    cipher_free(c);
+    return ok;
+}
+
+static void test_utf32(void)
+{
+    print_section("ТЕСТЫ UTF-32");
+    assert_true(utf32_matches_utf8(), "UTF-32 совпадает с UTF-8");
+    assert_true(utf32_invalid_code_point(), "Суррогат отвергается");
+}
+
+/* ===================== ТЕСТЫ ДЕСКРИПТОРОВ ===================== */
+static void test_handles(void)
+{
+    cipher_handle* c = (cipher_handle*)1;
+    size_t out_len;
+    const uint32_t key[] = {0x41A, 0x41B, 0x42E, 0x427}; /* КЛЮЧ */
+    const char bad_utf8[] = {'\xD0', '\x9A', '\xD0'}; /* К и оборванная буква */
+    const uint32_t surrogate[] = {0x41A, 0xD800};
+
+    print_section("ТЕСТЫ ДЕСКРИПТОРОВ");
+    assert_true(cipher_gronsfeld_new("КЛЮЧ1", strlen("КЛЮЧ1"), &c) == CIPHER_INVALID_KEY && c == NULL,
+                "Недопустимый ключ");
+    assert_true(cipher_gronsfeld_new("", 0, &c) == CIPHER_INVALID_KEY, "Пустой ключ");
+    c = (cipher_handle*)1;
+    assert_true(cipher_gronsfeld_new(bad_utf8, sizeof(bad_utf8), &c) == CIPHER_INVALID_ENCODING && c == NULL,
+                "Ключ с испорченным UTF-8");
+    assert_true(cipher_gronsfeld_new_utf32(surrogate, 2, &c) == CIPHER_INVALID_ENCODING,
+                "Ключ UTF-32 с суррогатом");
+    assert_true(cipher_route_new(0, &c) == CIPHER_INVALID_KEY, "Нулевое число столбцов");
+    assert_true(cipher_route_new(101, &c) == CIPHER_INVALID_KEY, "Слишком много столбцов");
+    assert_true(cipher_gronsfeld_new_utf32(key, 4, &c) == CIPHER_OK, "Ключ в UTF-32");
+    cipher_free(c);
+    assert_true(cipher_encrypt_utf8(NULL, "А", 2, NULL, 0, &out_len) == CIPHER_INVALID_ARGUMENT,
+                "Нулевой дескриптор");
+    cipher_free(NULL);
+    assert_true(strcmp(cipher_status_message(CIPHER_BUFFER_TOO_SMALL), "Output buffer is too small") == 0,
+                "Сообщения статусов");
+    assert_true(strcmp(cipher_status_message(CIPHER_INTERNAL_ERROR), "Internal error") == 0
+                    && strcmp(cipher_status_message(CIPHER_INVALID_ARGUMENT), "Invalid argument") == 0,
+                "Внутренняя ошибка отличается от неверного аргумента");
+}
+
+/* ===================== ОСНОВНАЯ ФУНКЦИЯ ===================== */
+int main(void)
+{
+    setlocale(LC_ALL, "ru_RU.UTF-8");
+
+    printf("\n======================================================================\n");
+    printf("МОДУЛЬНОЕ ТЕСТИРОВАНИЕ C-ИНТЕРФЕЙСА LIBCIPHER\n");
+    printf("======================================================================\n");
+
+    test_utf8();
+    test_utf32();
+    test_handles();
+
+    printf("\n======================================================================\n");
+    printf("ИТОГИ ТЕСТИРОВАНИЯ\n");
+    printf("======================================================================\n");
+    printf("Всего тестов: %d\n", total_tests);
+    printf("Пройдено: %d\n", passed_tests);
+    printf("Не пройдено: %d\n", total_tests - passed_tests);
+
+    if (passed_tests == total_tests) {
+        printf("\n✓ ВСЕ ТЕСТЫ УСПЕШНО ПРОЙДЕНЫ!\n");
+        return 0;
+    }
+    printf("\n✗ ТЕСТИРОВАНИЕ НЕ УСПЕШНО\n");
+    return 1;
+}
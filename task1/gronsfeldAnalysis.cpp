@@ -0,0 +1,184 @@
+#include "gronsfeldAnalysis.h"
+#include "modAlphaCipher.h"
+#include "../common/parallel.h"
+#include <algorithm>
+#include <cwctype>
+
+const double russianFrequencies[33] = {
+	8.01, 1.59, 4.54, 1.70, 2.98, 8.45, 0.04, 0.94, 1.65, 7.35, 1.21,
+	3.49, 4.40, 3.21, 6.70, 10.97, 2.81, 4.73, 5.47, 6.26, 2.62, 0.26,
+	0.97, 0.48, 1.44, 0.73, 0.36, 0.04, 1.90, 1.74, 0.32, 0.64, 2.01
+};
+
+namespace {
+
+const int letters = 33;
+// Строка гистограммы выровнена до 36 счетчиков, чтобы циклы по ней векторизовались
+const int stride = 36;
+
+// Индекс совпадений одного столбца: сумма n(n-1) / N(N-1)
+double coincidence(const uint32_t* h)
+{
+	uint64_t pairs = 0;
+	uint64_t total = 0;
+	for (int v = 0; v < stride; v++) {
+		pairs += static_cast<uint64_t>(h[v]) * (h[v] - 1u); // при h[v] == 0 слагаемое 0
+		total += h[v];
+	}
+	return total > 1 ? static_cast<double>(pairs) / (static_cast<double>(total) * (total - 1)) : 0;
+}
+
+// Сдвиг столбца с наименьшим хи-квадрат относительно частот русского языка
+int bestShift(const uint32_t* h, double& chi)
+{
+	double total = 0;
+	double doubled[2 * letters]; // удвоенная строка: сдвиг без взятия остатка
+	for (int v = 0; v < letters; v++) {
+		doubled[v] = doubled[v + letters] = h[v];
+		total += h[v];
+	}
+	double expected[letters];
+	double inverse[letters];
+	for (int v = 0; v < letters; v++) {
+		expected[v] = total * russianFrequencies[v] / 100;
+		inverse[v] = 1 / expected[v];
+	}
+	int best = 0;
+	chi = -1;
+	for (int s = 0; s < letters; s++) {
+		const double* observed = doubled + s;
+		double sum = 0;
+		for (int v = 0; v < letters; v++) {
+			double d = observed[v] - expected[v];
+			sum += d * d * inverse[v];
+		}
+		if (chi < 0 || sum < chi) {
+			chi = sum;
+			best = s;
+		}
+	}
+	return best;
+}
+
+}
+
+gronsfeldAnalyzer::gronsfeldAnalyzer(const std::wstring& cipher_text, unsigned thread_count):
+	threads(thread_count)
+{
+	// Таблица перевода символа в номер буквы, включая строчные
+	const std::wstring& alpha = modAlphaCipher::alphabet();
+	std::wstring lower(alpha);
+	for (auto& c : lower) {
+		c = towlower(c);
+	}
+	wchar_t low = std::min(*std::min_element(alpha.begin(), alpha.end()),
+	                       *std::min_element(lower.begin(), lower.end()));
+	wchar_t high = std::max(*std::max_element(alpha.begin(), alpha.end()),
+	                        *std::max_element(lower.begin(), lower.end()));
+	std::vector<int> index(high - low + 1, -1);
+	for (size_t i = 0; i < alpha.size(); i++) {
+		index[alpha[i] - low] = i;
+		index[lower[i] - low] = i;
+	}
+
+	text.reserve(cipher_text.size());
+	for (auto c : cipher_text) {
+		if (c >= low && c <= high && index[c - low] >= 0) {
+			text.push_back(static_cast<uint8_t>(index[c - low]));
+		}
+	}
+}
+
+// Гистограммы букв для каждого столбца периода: period строк по stride счетчиков
+void gronsfeldAnalyzer::histograms(int period, std::vector<uint32_t>& hist) const
+{
+	hist.assign(static_cast<size_t>(period) * stride, 0);
+	uint32_t* first = hist.data();
+	uint32_t* last = first + hist.size();
+	uint32_t* row = first;
+	for (uint8_t v : text) {
+		row[v]++;
+		row += stride;
+		if (row == last)
+			row = first;
+	}
+}
+
+std::vector<periodScore> gronsfeldAnalyzer::scorePeriods(int maxPeriod) const
+{
+	// В каждом столбце нужно хотя бы две буквы
+	maxPeriod = std::min<long long>(maxPeriod, text.size() / 2);
+	if (maxPeriod < 1)
+		throw cipher_error("Cipher text is too short for analysis");
+	std::vector<periodScore> scores(maxPeriod);
+	parallelFor(maxPeriod, threads, [&](size_t i) {
+		int period = i + 1;
+		std::vector<uint32_t> hist;
+		histograms(period, hist);
+		double sum = 0;
+		double chiSum = 0;
+		for (int c = 0; c < period; c++) {
+			double chi;
+			sum += coincidence(hist.data() + c * stride);
+			bestShift(hist.data() + c * stride, chi);
+			chiSum += chi;
+		}
+		scores[i].period = period;
+		scores[i].coincidence = sum / period;
+		scores[i].chiSquared = chiSum / period;
+	});
+	return scores;
+}
+
+// Кратные истинного периода дают почти тот же индекс совпадений,
+// поэтому берем наименьший период, близкий к лучшему
+int gronsfeldAnalyzer::estimatePeriod(const std::vector<periodScore>& scores) const
+{
+	if (scores.empty())
+		throw cipher_error("No periods to choose from");
+	const double random = 1.0 / letters;
+	double best = random;
+	for (const auto& s : scores) {
+		best = std::max(best, s.coincidence);
+	}
+	double threshold = random + 0.8 * (best - random);
+	for (const auto& s : scores) {
+		if (s.coincidence >= threshold)
+			return s.period;
+	}
+	return scores.front().period;
+}
+
+std::wstring gronsfeldAnalyzer::recoverKey(int period, double* chiSquared) const
+{
+	if (period < 1 || static_cast<size_t>(period) > text.size())
+		throw cipher_error("Invalid key period");
+	std::vector<uint32_t> hist;
+	histograms(period, hist);
+	std::vector<int> shifts(period);
+	std::vector<double> chi(period);
+	parallelFor(period, threads, [&](size_t c) {
+		shifts[c] = bestShift(hist.data() + c * stride, chi[c]);
+	});
+
+	const std::wstring& alpha = modAlphaCipher::alphabet();
+	std::wstring key;
+	double sum = 0;
+	for (int c = 0; c < period; c++) {
+		key.push_back(alpha[shifts[c]]);
+		sum += chi[c];
+	}
+	if (chiSquared)
+		*chiSquared = sum / period;
+	return key;
+}
+
+gronsfeldAudit gronsfeldAnalyzer::audit(int maxPeriod) const
+{
+	gronsfeldAudit report;
+	report.periods = scorePeriods(maxPeriod);
+	report.period = estimatePeriod(report.periods);
+	report.key = recoverKey(report.period, &report.chiSquared);
+	report.lettersPerColumn = text.size() / report.period;
+	return report;
+}
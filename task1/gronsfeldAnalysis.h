@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Частоты букв русского текста в порядке modAlphaCipher::alphabet(), %
+extern const double russianFrequencies[33];
+
+// Оценки шифротекста, разрезанного на period столбцов
+struct periodScore {
+	int period;
+	double coincidence; // индекс совпадений, среднее по столбцам; для русского текста около 0.055, для случайного 1/33
+	double chiSquared;  // хи-квадрат лучшего сдвига, среднее по столбцам; около 32 на периоде и его кратных
+};
+
+// Итог аудита: найденный период и наиболее вероятный ключ
+struct gronsfeldAudit {
+	std::vector<periodScore> periods;
+	int period = 0;
+	std::wstring key;
+	double chiSquared = 0;       // среднее по столбцам, чем меньше, тем надежнее ключ
+	size_t lettersPerColumn = 0;
+};
+
+// Криптоанализ шифра Гронсфельда (modAlphaCipher) по частотам букв.
+// Работает на алфавите modAlphaCipher::alphabet(); символы вне алфавита
+// в шифротексте пропускаются. Периоды и столбцы считаются на нескольких потоках.
+class gronsfeldAnalyzer
+{
+private:
+	std::vector<uint8_t> text; // номера букв шифротекста
+	unsigned threads;
+	void histograms(int period, std::vector<uint32_t>& hist) const;
+public:
+	gronsfeldAnalyzer()=delete;
+	// threads = 0 - по числу ядер
+	explicit gronsfeldAnalyzer(const std::wstring& cipher_text, unsigned thread_count = 0);
+	size_t size() const { return text.size(); }
+
+	std::vector<periodScore> scorePeriods(int maxPeriod = 200) const;
+	int estimatePeriod(const std::vector<periodScore>& scores) const;
+	std::wstring recoverKey(int period, double* chiSquared = nullptr) const;
+	gronsfeldAudit audit(int maxPeriod = 200) const;
+};
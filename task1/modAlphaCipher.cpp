@@ -1,88 +1,264 @@
 #include "modAlphaCipher.h"
+#include "../common/arena.h"
+#include "../common/cipherProfile.h"
+
+static std::string toBytes(std::wstring_view ws)
+{
+	std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> codec;
+	return codec.to_bytes(ws.data(), ws.data() + ws.size());
+}
+
+static void throwEncryptError(cipherStatus status, std::wstring_view open_text, size_t pos)
+{
+	if (status == cipherStatus::emptyText)
+		throw cipher_error("Empty open text");
+	throw cipher_error(std::string(statusMessage(status))+" "+toBytes(open_text.substr(pos, 1)));
+}
+
+static void throwDecryptError(cipherStatus status, std::wstring_view cipher_text)
+{
+	if (status == cipherStatus::emptyText)
+		throw cipher_error("Output text is missing");
+	if (status == cipherStatus::invalidText)
+		throw cipher_error(std::string("Invalid text")+toBytes(cipher_text));
+	throw cipher_error(std::string(statusMessage(status))+" "+toBytes(cipher_text));
+}
+
+const char* statusMessage(cipherStatus status)
+{
+	switch (status) {
+	case cipherStatus::ok:
+		return "Ok";
+	case cipherStatus::emptyText:
+		return "Empty text";
+	case cipherStatus::invalidText:
+		return "Invalid text";
+	case cipherStatus::outOfAlphabet:
+		return "Symbol out of alphabet";
+	}
+	return "Unknown error";
+}
+
+const std::wstring& modAlphaCipher::alphabet()
+{
+	static const std::wstring letters = L"АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ";
+	return letters;
+}
 
 modAlphaCipher::modAlphaCipher(const std::wstring& wskey)
 { 
 	for (unsigned i=0; i<numAlpha.size(); i++) {
         alphaNum[numAlpha[i]]=i;
     }
-    key = convert(getValidKey(wskey));
+    convert(getValidKey(wskey), key);
+}
+
+std::wstring modAlphaCipher::encrypt(const std::wstring& open_text) const
+{
+    cipherResult r = tryEncrypt(open_text);
+    if (!r)
+        throwEncryptError(r.status, open_text, r.position);
+    return r.text;
+}
+
+std::wstring modAlphaCipher::decrypt(const std::wstring& cipher_text) const
+{
+    cipherResult r = tryDecrypt(cipher_text);
+    if (!r)
+        throwDecryptError(r.status, cipher_text);
+    return r.text;
+}
+
+std::pmr::wstring modAlphaCipher::encrypt(std::wstring_view open_text, std::pmr::memory_resource* resource) const
+{
+    std::pmr::wstring result(resource);
+    size_t pos = 0;
+    cipherStatus status = encryptTo(open_text, result, pos);
+    if (status != cipherStatus::ok)
+        throwEncryptError(status, open_text, pos);
+    return result;
+}
+
+std::pmr::wstring modAlphaCipher::decrypt(std::wstring_view cipher_text, std::pmr::memory_resource* resource) const
+{
+    std::pmr::wstring result(resource);
+    size_t pos = 0;
+    cipherStatus status = decryptTo(cipher_text, result, pos);
+    if (status != cipherStatus::ok)
+        throwDecryptError(status, cipher_text);
+    return result;
+}
+
+cipherResult modAlphaCipher::tryEncrypt(const std::wstring& open_text) const
+{
+    cipherResult r;
+    r.status = encryptTo(open_text, r.text, r.position);
+    return r;
+}
+
+cipherResult modAlphaCipher::tryDecrypt(const std::wstring& cipher_text) const
+{
+    cipherResult r;
+    r.status = decryptTo(cipher_text, r.text, r.position);
+    return r;
+}
+
+cipherStatus modAlphaCipher::tryEncrypt(std::wstring_view open_text, std::pmr::wstring& out, size_t& pos) const
+{
+    return encryptTo(open_text, out, pos);
+}
+
+cipherStatus modAlphaCipher::tryDecrypt(std::wstring_view cipher_text, std::pmr::wstring& out, size_t& pos) const
+{
+    return decryptTo(cipher_text, out, pos);
+}
+
+template <class String>
+cipherStatus modAlphaCipher::encryptTo(std::wstring_view open_text, String & out, size_t & pos) const
+{
+    String valid(out.get_allocator());
+    cipherStatus status = getValidOpenText(open_text, valid, pos);
+    if (status != cipherStatus::ok)
+        return status;
+    arenaVector<String, int> work(out.get_allocator());
+    convert(valid, work);
+    {
+        CIPHER_STAGE(transform, work.size() * sizeof(int));
+        for(unsigned i=0; i < work.size(); i++) {
+            work[i] = (work[i] + key[i % key.size()]) % numAlpha.size();
+        }
+    }
+    convert(work, out);
+    return status;
 }
 
-std::wstring modAlphaCipher::encrypt(const std::wstring& open_text)
+template <class String>
+cipherStatus modAlphaCipher::decryptTo(std::wstring_view cipher_text, String & out, size_t & pos) const
 {
-    std::vector<int> work = convert(getValidOpenText(open_text));
-    for(unsigned i=0; i < work.size(); i++) {
-        work[i] = (work[i] + key[i % key.size()]) % alphaNum.size();
+    cipherStatus status = getValidCipherText(cipher_text, pos);
+    if (status != cipherStatus::ok)
+        return status;
+    arenaVector<String, int> work(out.get_allocator());
+    convert(cipher_text, work);
+    {
+        CIPHER_STAGE(transform, work.size() * sizeof(int));
+        for(unsigned i=0; i < work.size(); i++) {
+            work[i] = (work[i] + numAlpha.size() - key[i % key.size()]) % numAlpha.size();
+        }
     }
-    return convert(work);
+    convert(work, out);
+    return status;
+}
+
+std::wstring modAlphaCipher::encryptPreserving(const std::wstring& text) const
+{
+    return shiftPreserving(text, false);
 }
 
-std::wstring modAlphaCipher::decrypt(const std::wstring& cipher_text)
+std::wstring modAlphaCipher::decryptPreserving(const std::wstring& text) const
 {
-    std::vector<int> work = convert(getValidCipherText(cipher_text));
-    for(unsigned i=0; i < work.size(); i++) {
-        work[i] = (work[i] + alphaNum.size() - key[i % key.size()]) % alphaNum.size();
+    return shiftPreserving(text, true);
+}
+
+// Один проход: буква алфавита сдвигается на очередной элемент ключа,
+// остальное копируется как есть
+std::wstring modAlphaCipher::shiftPreserving(const std::wstring & ws, bool decrypting) const
+{
+    CIPHER_STAGE(transform, ws.size() * sizeof(wchar_t));
+    const int n = numAlpha.size();
+    std::wstring result(ws);
+    size_t phase = 0;
+    for (auto & c:result) {
+        bool lower = iswlower(c);
+        auto it = alphaNum.find(lower ? towupper(c) : c);
+        if (it == alphaNum.end())
+            continue;
+        int k = key[phase];
+        if (++phase == key.size())
+            phase = 0;
+        wchar_t shifted = numAlpha[(it->second + (decrypting ? n - k : k)) % n];
+        c = lower ? towlower(shifted) : shifted;
     }
-    return convert(work);
+    return result;
 }
 
-inline std::vector<int> modAlphaCipher::convert(const std::wstring& ws)
+// Вход уже проверен: все символы есть в алфавите
+template <class Vector>
+inline void modAlphaCipher::convert(std::wstring_view ws, Vector & out) const
 { 
-	std::vector<int> result;
+	CIPHER_STAGE(convert, ws.size() * sizeof(wchar_t));
+	out.reserve(ws.size());
 	for(auto c:ws) {
-		result.push_back(alphaNum[c]);
+		out.push_back(alphaNum.find(c)->second);
 	}
-	return result;
 }
 
-inline std::wstring modAlphaCipher::convert(const std::vector<int>& v)
+template <class Alloc, class String>
+inline void modAlphaCipher::convert(const std::vector<int, Alloc> & v, String & out) const
 { 
-	std::wstring result;
+	CIPHER_STAGE(output, v.size() * sizeof(int));
+	out.reserve(v.size());
 	for(auto i:v) {
-		result.push_back(numAlpha[i]);
+		out.push_back(numAlpha[i]);
 	}
-	return result;
 }
 
-inline std::wstring modAlphaCipher::getValidKey(const std::wstring & ws)
+inline std::wstring modAlphaCipher::getValidKey(const std::wstring & ws) const
 { 
 	if (ws.empty())
         throw cipher_error("Empty key");
     std::wstring tmp(ws);
-    std::string s = codec.to_bytes(ws);
 	for (auto & c:tmp) {
 		if (!iswalpha(c))
-			throw cipher_error(std::string("Invalid key ")+s);
+			throw cipher_error(std::string("Invalid key ")+toBytes(ws));
 		if (iswlower(c))
 		c = towupper(c);
+		if (!alphaNum.count(c))
+			throw cipher_error(std::string("Invalid key ")+toBytes(ws));
 	}
 	return tmp;
 }
 
-inline std::wstring modAlphaCipher::getValidOpenText(const std::wstring & ws)
+template <class String>
+inline cipherStatus modAlphaCipher::getValidOpenText(std::wstring_view ws, String & out, size_t & pos) const
 { 
-	
-	std::wstring tmp;
-	for (auto c:ws) {
+	CIPHER_STAGE(validate, ws.size() * sizeof(wchar_t));
+	out.reserve(ws.size());
+	for (size_t i = 0; i < ws.size(); i++) {
+		wchar_t c = ws[i];
 		if (iswalpha(c)) {
 			if (iswlower(c))
-				tmp.push_back(toupper(c));
-		else tmp.push_back(c);
+				c = towupper(c);
+			if (!alphaNum.count(c)) {
+				pos = i;
+				return cipherStatus::outOfAlphabet;
+			}
+			out.push_back(c);
 		}
 	}
-	if (tmp.empty())
-		throw cipher_error("Empty open text");
-return tmp;
+	if (out.empty()) {
+		pos = ws.size();
+		return cipherStatus::emptyText;
+	}
+	return cipherStatus::ok;
 }
 
-inline std::wstring modAlphaCipher::getValidCipherText(const std::wstring & ws)
+inline cipherStatus modAlphaCipher::getValidCipherText(std::wstring_view ws, size_t & pos) const
 {
-    if (ws.empty())
-        throw cipher_error("Output text is missing");
-    for (auto c:ws) {
-        std::string s = codec.to_bytes(ws);
-        if (!iswupper(c))
-            throw cipher_error(std::string("Invalid text")+s);
+    CIPHER_STAGE(validate, ws.size() * sizeof(wchar_t));
+    if (ws.empty()) {
+        pos = 0;
+        return cipherStatus::emptyText;
+    }
+    for (size_t i = 0; i < ws.size(); i++) {
+        if (!iswupper(ws[i])) {
+            pos = i;
+            return cipherStatus::invalidText;
+        }
+        if (!alphaNum.count(ws[i])) {
+            pos = i;
+            return cipherStatus::outOfAlphabet;
+        }
     }
-    return ws;
+    return cipherStatus::ok;
 }
@@ -4,23 +4,63 @@
 #include <map>
 #include <codecvt>
 #include <locale>
+#include <memory_resource>
+#include <stdexcept>
+#include <string_view>
+
+// Результат проверки и шифрования без исключений
+enum class cipherStatus {
+	ok,
+	emptyText,     // пустой текст или открытый текст без букв
+	invalidText,   // в шифротексте есть символ, не являющийся заглавной буквой
+	outOfAlphabet  // буква не из русского алфавита
+};
+
+struct cipherResult {
+	cipherStatus status = cipherStatus::ok;
+	size_t position = 0; // индекс первого ошибочного символа во входной строке
+	std::wstring text;
+	explicit operator bool() const { return status == cipherStatus::ok; }
+};
+
+const char* statusMessage(cipherStatus status);
+
+// Шифр Гронсфельда над русским алфавитом. Методы шифрования не меняют объект,
+// поэтому один экземпляр можно делить между потоками. encrypt/decrypt бросают
+// cipher_error, tryEncrypt/tryDecrypt возвращают ту же ошибку входа статусом и
+// позицией символа. Перегрузки с pmr берут результат и временные буферы из
+// переданного распределителя (resource или распределитель out).
 class modAlphaCipher
 {
 private:
-	std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> codec;
-	std::wstring numAlpha = L"АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ";
+	std::wstring numAlpha = alphabet();
 	std::map <wchar_t,int> alphaNum;
 	std::vector <int> key;
-	std::vector<int> convert(const std::wstring& ws);
-	std::wstring convert(const std::vector<int>& v);
-	std::wstring getValidKey(const std::wstring & ws);
-	std::wstring getValidOpenText(const std::wstring & ws);
-	std::wstring getValidCipherText(const std::wstring & ws);
+	// String - std::wstring или std::pmr::wstring; временные буферы берут его распределитель
+	template <class Vector> void convert(std::wstring_view ws, Vector & out) const;
+	template <class Alloc, class String> void convert(const std::vector<int, Alloc> & v, String & out) const;
+	std::wstring getValidKey(const std::wstring & ws) const;
+	template <class String> cipherStatus getValidOpenText(std::wstring_view ws, String & out, size_t & pos) const;
+	cipherStatus getValidCipherText(std::wstring_view ws, size_t & pos) const;
+	template <class String> cipherStatus encryptTo(std::wstring_view open_text, String & out, size_t & pos) const;
+	template <class String> cipherStatus decryptTo(std::wstring_view cipher_text, String & out, size_t & pos) const;
+	std::wstring shiftPreserving(const std::wstring & ws, bool decrypting) const;
 public:
 	modAlphaCipher()=delete; //запретим конструктор без параметров
 	modAlphaCipher(const std::wstring& wskey); //конструктор для установки ключа
-	std::wstring encrypt(const std::wstring& open_text);
-	std::wstring decrypt(const std::wstring& cipher_text);
+	static const std::wstring& alphabet(); // алфавит шифра, номер буквы - ее сдвиг
+	std::wstring encrypt(const std::wstring& open_text) const;
+	std::wstring decrypt(const std::wstring& cipher_text) const;
+	cipherResult tryEncrypt(const std::wstring& open_text) const;
+	cipherResult tryDecrypt(const std::wstring& cipher_text) const;
+	std::pmr::wstring encrypt(std::wstring_view open_text, std::pmr::memory_resource* resource) const;
+	std::pmr::wstring decrypt(std::wstring_view cipher_text, std::pmr::memory_resource* resource) const;
+	cipherStatus tryEncrypt(std::wstring_view open_text, std::pmr::wstring& out, size_t& pos) const;
+	cipherStatus tryDecrypt(std::wstring_view cipher_text, std::pmr::wstring& out, size_t& pos) const;
+	// Режим с сохранением формата: символы вне алфавита остаются на своих местах
+	// и не сдвигают фазу ключа, регистр букв сохраняется. Ошибок входа нет.
+	std::wstring encryptPreserving(const std::wstring& text) const;
+	std::wstring decryptPreserving(const std::wstring& text) const;
 };
 
 class cipher_error: public std::invalid_argument {
@@ -3,7 +3,14 @@
 #include <cctype>
 #include <codecvt>
 #include <string>
+#include <random>
+#include <thread>
+#include <future>
+#include <memory_resource>
+#include <algorithm>
 #include "modAlphaCipher.h"
+#include "gronsfeldAnalysis.h"
+#include "../common/cipherProfile.h"
 
 using namespace std;
 
@@ -98,6 +105,12 @@ void test_encrypt() {
         return clean == dirty;
     }(), "Удаление не-буквенных символов");
     
+    // Приведение к верхнему регистру
+    assert_true([]() {
+        modAlphaCipher cipher(L"В");
+        return cipher.encrypt(L"привет") == cipher.encrypt(L"ПРИВЕТ");
+    }(), "Автоматическое приведение к верхнему регистру");
+    
     // Исключения
     assert_exception([]() {
         modAlphaCipher cipher(L"Г");
@@ -109,6 +122,11 @@ void test_encrypt() {
         cipher.encrypt(L"123!@#");
     }, "Текст без букв для шифрования");
     
+    assert_exception([]() {
+        modAlphaCipher cipher(L"Д");
+        cipher.encrypt(L"ТЕКСТ text");
+    }, "Буквы вне алфавита");
+    
     // Длинный текст
     assert_true([]() {
         modAlphaCipher cipher(L"ШИФР");
@@ -161,6 +179,17 @@ void test_decrypt() {
         modAlphaCipher cipher(L"З");
         cipher.decrypt(L"ШИФР!ТЕКСТ");
     }, "Шифротекст со спецсимволами");
+
+    // Текст ошибки прежний: "Invalid text" и шифротекст без пробела
+    assert_true([]() {
+        modAlphaCipher cipher(L"И");
+        try {
+            cipher.decrypt(L"АБ1");
+        } catch (const cipher_error& e) {
+            return string(e.what()) == "Invalid textАБ1";
+        }
+        return false;
+    }(), "Сообщение об ошибке шифротекста");
 }
 
 // ===================== ТЕСТЫ ГРАНИЧНЫХ СЛУЧАЕВ =====================
@@ -247,6 +276,330 @@ void test_integration() {
     }(), "Разные ключи дают разные результаты");
 }
 
+// ===================== ТЕСТЫ API БЕЗ ИСКЛЮЧЕНИЙ =====================
+void test_try_api() {
+    print_section("ТЕСТЫ API БЕЗ ИСКЛЮЧЕНИЙ");
+    
+    // Успешный результат совпадает с encrypt/decrypt
+    assert_true([]() {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        cipherResult enc = cipher.tryEncrypt(L"при вет!");
+        cipherResult dec = cipher.tryDecrypt(enc.text);
+        return enc && dec && enc.text == cipher.encrypt(L"ПРИВЕТ") && dec.text == L"ПРИВЕТ";
+    }(), "tryEncrypt/tryDecrypt совпадают с encrypt/decrypt");
+    
+    // Открытый текст без букв
+    assert_true([]() {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        cipherResult r = cipher.tryEncrypt(L"123!@#");
+        return r.status == cipherStatus::emptyText && r.position == 6 && r.text.empty();
+    }(), "tryEncrypt: текст без букв");
+    
+    // Буква вне алфавита
+    assert_true([]() {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        cipherResult r = cipher.tryEncrypt(L"ТЕКСТ text");
+        return r.status == cipherStatus::outOfAlphabet && r.position == 6;
+    }(), "tryEncrypt: позиция буквы вне алфавита");
+    
+    // Пустой шифротекст
+    assert_true([]() {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        return cipher.tryDecrypt(L"").status == cipherStatus::emptyText;
+    }(), "tryDecrypt: пустой шифротекст");
+    
+    // Недопустимый символ шифротекста
+    assert_true([]() {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        cipherResult r = cipher.tryDecrypt(L"ШИФР1ТЕКСТ");
+        return r.status == cipherStatus::invalidText && r.position == 4;
+    }(), "tryDecrypt: позиция недопустимого символа");
+    
+    // Строчные буквы в шифротексте
+    assert_true([]() {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        cipherResult r = cipher.tryDecrypt(L"ШИФРт");
+        return r.status == cipherStatus::invalidText && r.position == 4;
+    }(), "tryDecrypt: строчная буква");
+}
+
+// ===================== ТЕСТЫ РАБОТЫ С АРЕНОЙ =====================
+void test_arena() {
+    print_section("ТЕСТЫ РАБОТЫ С АРЕНОЙ");
+    
+    // Совпадает с обычным API
+    assert_true([]() {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        pmr::monotonic_buffer_resource arena;
+        pmr::wstring enc = cipher.encrypt(L"при вет, мир!", &arena);
+        pmr::wstring dec = cipher.decrypt(enc, &arena);
+        return enc == cipher.encrypt(L"ПРИВЕТМИР").c_str() && dec == L"ПРИВЕТМИР";
+    }(), "encrypt/decrypt с ареной совпадают с обычными");
+    
+    // Все промежуточные буферы помещаются в арену без обращения к куче:
+    // у арены нет вышестоящего ресурса, выход за буфер дал бы bad_alloc
+    assert_true([]() {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        wchar_t buffer[4096];
+        pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), pmr::null_memory_resource());
+        pmr::wstring enc = cipher.encrypt(L"ПРИВЕТМИР", &arena);
+        pmr::wstring dec = cipher.decrypt(enc, &arena);
+        return dec == L"ПРИВЕТМИР" && enc.get_allocator().resource() == &arena;
+    }(), "Временные буферы берутся из арены");
+    
+    assert_exception([]() {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        pmr::monotonic_buffer_resource arena;
+        cipher.encrypt(L"123", &arena);
+    }, "Текст без букв с ареной");
+    
+    assert_exception([]() {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        pmr::monotonic_buffer_resource arena;
+        cipher.decrypt(L"ШИФРт", &arena);
+    }, "Строчная буква в шифротексте с ареной");
+}
+
+// ===================== ТЕСТЫ РЕЖИМА С СОХРАНЕНИЕМ ФОРМАТА =====================
+void test_preserving() {
+    print_section("ТЕСТЫ РЕЖИМА С СОХРАНЕНИЕМ ФОРМАТА");
+    
+    // Не-буквы на своих местах, буквы совпадают с обычным режимом
+    assert_true([]() {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        wstring result = cipher.encryptPreserving(L"ПРИ ВЕТ, 12 МИР!");
+        wstring letters;
+        for (auto c : result) {
+            if (c != L' ' && c != L',' && c != L'!' && c != L'1' && c != L'2') {
+                letters += c;
+            }
+        }
+        return result.size() == 16 && result[3] == L' ' && result.substr(7, 4) == L", 12"
+            && result[15] == L'!' && letters == cipher.encrypt(L"ПРИВЕТМИР");
+    }(), "Не-буквы остаются на месте и не сдвигают ключ");
+    
+    // Полный цикл
+    assert_true([]() {
+        modAlphaCipher cipher(L"ШИФР");
+        wstring original = L"Съешь же ещё этих мягких французских булок, да выпей чаю. 2024 Hello";
+        return cipher.decryptPreserving(cipher.encryptPreserving(original)) == original;
+    }(), "Полный цикл с сохранением формата");
+    
+    // Регистр сохраняется, латиница не меняется
+    assert_true([]() {
+        modAlphaCipher cipher(L"Б");
+        return cipher.encryptPreserving(L"Аб Hi") == L"Бв Hi";
+    }(), "Сохранение регистра и символов вне алфавита");
+    
+    // Текст без букв
+    assert_true([]() {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        return cipher.encryptPreserving(L"") == L"" && cipher.encryptPreserving(L"12, 34!") == L"12, 34!";
+    }(), "Текст без букв возвращается без изменений");
+}
+
+// ===================== ТЕСТЫ КРИПТОАНАЛИЗА =====================
+// Текст с частотами букв русского языка (независимые буквы)
+wstring russian_like_text(size_t length, unsigned seed) {
+    mt19937 rng(seed);
+    discrete_distribution<int> pick(begin(russianFrequencies), end(russianFrequencies));
+    wstring text;
+    for (size_t i = 0; i < length; i++) {
+        text += modAlphaCipher::alphabet()[pick(rng)];
+    }
+    return text;
+}
+
+void test_analysis() {
+    print_section("ТЕСТЫ КРИПТОАНАЛИЗА ШИФРА ГРОНСФЕЛЬДА");
+    
+    // Период и ключ
+    assert_true([]() {
+        modAlphaCipher cipher(L"ШИФРОВАНИЕ");
+        gronsfeldAnalyzer analyzer(cipher.encrypt(russian_like_text(20000, 1)));
+        gronsfeldAudit report = analyzer.audit(60);
+        return report.period == 10 && report.key == L"ШИФРОВАНИЕ"
+            && report.periods.size() == 60 && report.lettersPerColumn == 2000;
+    }(), "Восстановление периода и ключа");
+    
+    // Ключ из одной буквы
+    assert_true([]() {
+        modAlphaCipher cipher(L"Я");
+        gronsfeldAnalyzer analyzer(cipher.encrypt(russian_like_text(3000, 2)));
+        gronsfeldAudit report = analyzer.audit(20);
+        return report.period == 1 && report.key == L"Я";
+    }(), "Ключ длины 1");
+    
+    // Индекс совпадений: высокий на периоде, как у случайного текста вне его
+    assert_true([]() {
+        modAlphaCipher cipher(L"КЛЮЧИК");
+        gronsfeldAnalyzer analyzer(cipher.encrypt(russian_like_text(12000, 3)));
+        vector<periodScore> scores = analyzer.scorePeriods(12);
+        return scores[5].period == 6 && scores[5].coincidence > 0.05
+            && scores[11].coincidence > 0.05 && scores[4].coincidence < 0.04;
+    }(), "Индекс совпадений по периодам");
+
+    // Хи-квадрат: наименьший на истинном периоде (кратные за пределами поиска)
+    assert_true([]() {
+        modAlphaCipher cipher(L"СЕМЕРКА");
+        gronsfeldAnalyzer analyzer(cipher.encrypt(russian_like_text(14000, 6)));
+        vector<periodScore> scores = analyzer.scorePeriods(13);
+        auto best = min_element(scores.begin(), scores.end(),
+            [](const periodScore& a, const periodScore& b) { return a.chiSquared < b.chiSquared; });
+        return best->period == 7 && best->chiSquared < 100 && scores[5].chiSquared > 1000;
+    }(), "Хи-квадрат по периодам");
+    
+    // Не-буквы и строчные буквы в шифротексте
+    assert_true([]() {
+        modAlphaCipher cipher(L"ПАРОЛЬ");
+        wstring encrypted = cipher.encrypt(russian_like_text(12000, 4));
+        wstring noisy;
+        for (size_t i = 0; i < encrypted.size(); i++) {
+            noisy += (i % 2) ? encrypted[i] : towlower(encrypted[i]);
+            if (i % 7 == 0) {
+                noisy += L" 1,";
+            }
+        }
+        gronsfeldAnalyzer analyzer(noisy);
+        return analyzer.size() == encrypted.size() && analyzer.recoverKey(6) == L"ПАРОЛЬ";
+    }(), "Символы вне алфавита пропускаются");
+    
+    // Результат не зависит от числа потоков
+    assert_true([]() {
+        modAlphaCipher cipher(L"ДЛИННЫЙКЛЮЧ");
+        wstring encrypted = cipher.encrypt(russian_like_text(15000, 5));
+        gronsfeldAudit one = gronsfeldAnalyzer(encrypted, 1).audit(40);
+        gronsfeldAudit many = gronsfeldAnalyzer(encrypted, 4).audit(40);
+        for (size_t i = 0; i < one.periods.size(); i++) {
+            if (one.periods[i].coincidence != many.periods[i].coincidence
+                || one.periods[i].chiSquared != many.periods[i].chiSquared) {
+                return false;
+            }
+        }
+        return one.key == many.key && one.period == many.period && one.key == L"ДЛИННЫЙКЛЮЧ";
+    }(), "Один и несколько потоков дают одинаковый результат");
+    
+    // Слишком короткий текст
+    assert_exception([]() {
+        gronsfeldAnalyzer analyzer(L"А");
+        analyzer.audit();
+    }, "Слишком короткий шифротекст");
+    
+    assert_exception([]() {
+        gronsfeldAnalyzer analyzer(L"АБВГ");
+        analyzer.recoverKey(0);
+    }, "Неверный период");
+}
+
+// ===================== ТЕСТЫ СЧЕТЧИКОВ ЭТАПОВ =====================
+void test_profile() {
+    print_section(profileEnabled ? "ТЕСТЫ СЧЕТЧИКОВ ЭТАПОВ (CIPHER_PROFILE)"
+                                 : "ТЕСТЫ СЧЕТЧИКОВ ЭТАПОВ (выключены)");
+    
+    // Счетчики заполняются только в сборке с CIPHER_PROFILE
+    assert_true([]() {
+        resetProfile();
+        modAlphaCipher cipher(L"КЛЮЧ");
+        wstring encrypted = cipher.encrypt(L"ПРИВЕТМИР");
+        cipher.decrypt(encrypted);
+        profileSnapshot p = takeProfile();
+        if (!profileEnabled) {
+            return p[profileStage::validate].calls == 0 && p[profileStage::output].calls == 0;
+        }
+        return p[profileStage::validate].calls == 2
+            && p[profileStage::validate].bytes == 18 * sizeof(wchar_t)
+            && p[profileStage::transform].calls == 2
+            && p[profileStage::output].calls == 2
+            && p[profileStage::output].allocations >= 2;
+    }(), "Счетчики этапов после encrypt/decrypt");
+
+    // Выделения считает operator new: по одному на каждый буфер этапа,
+    // а в арене с достаточным буфером - ни одного
+    assert_true([]() {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        resetProfile();
+        cipher.encrypt(L"ПРИВЕТМИР");
+        profileSnapshot heap = takeProfile();
+        char buffer[4096];
+        pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), pmr::null_memory_resource());
+        resetProfile();
+        cipher.encrypt(wstring_view(L"ПРИВЕТМИР"), &arena);
+        profileSnapshot pooled = takeProfile();
+        uint64_t expected = profileEnabled ? 1 : 0;
+        uint64_t pooledTotal = 0;
+        for (const auto& st : pooled.stages) {
+            pooledTotal += st.allocations;
+        }
+        return heap[profileStage::validate].allocations == expected
+            && heap[profileStage::convert].allocations == expected
+            && heap[profileStage::transform].allocations == 0
+            && heap[profileStage::output].allocations == expected
+            && pooledTotal == 0;
+    }(), "Выделения памяти по этапам: куча и арена");
+
+    // Снимок allThreads видит и живой рабочий поток, и завершившийся
+    assert_true([]() {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        resetProfile(profileScope::allThreads);
+        std::promise<void> done;
+        std::promise<void> release;
+        std::shared_future<void> released = release.get_future().share();
+        thread worker([&]() {
+            cipher.encrypt(L"ПРИВЕТ");
+            done.set_value();
+            released.wait();
+        });
+        done.get_future().wait();
+        profileSnapshot live = takeProfile(profileScope::allThreads);
+        profileSnapshot own = takeProfile();
+        release.set_value();
+        worker.join();
+        profileSnapshot retired = takeProfile(profileScope::allThreads);
+        uint64_t expected = profileEnabled ? 1 : 0;
+        return live[profileStage::transform].calls == expected
+            && retired[profileStage::transform].calls == expected
+            && retired[profileStage::transform].bytes == (profileEnabled ? 6 * sizeof(int) : 0u)
+            && own[profileStage::transform].calls == 0;
+    }(), "Снимок по всем потокам");
+    
+    // Сброс
+    assert_true([]() {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        cipher.encrypt(L"ТЕКСТ");
+        resetProfile();
+        profileSnapshot p = takeProfile();
+        for (const auto& s : p.stages) {
+            if (s.calls || s.nanoseconds || s.bytes || s.allocations) {
+                return false;
+            }
+        }
+        return true;
+    }(), "Сброс счетчиков");
+    
+    // Счетчики у каждого потока свои
+    assert_true([]() {
+        resetProfile();
+        uint64_t other = 0;
+        thread worker([&other]() {
+            modAlphaCipher cipher(L"КЛЮЧ");
+            cipher.encrypt(L"ТЕКСТ");
+            other = takeProfile()[profileStage::validate].calls;
+        });
+        worker.join();
+        return takeProfile()[profileStage::validate].calls == 0
+            && other == (profileEnabled ? 1u : 0u);
+    }(), "Счетчики раздельны по потокам");
+
+    // Ключ проходит этап convert, но не validate
+    assert_true([]() {
+        resetProfile();
+        modAlphaCipher cipher(L"КЛЮЧ");
+        profileSnapshot p = takeProfile();
+        return p[profileStage::validate].calls == 0
+            && p[profileStage::convert].calls == (profileEnabled ? 1u : 0u);
+    }(), "Конструктор учитывается только в convert");
+}
+
 // ===================== ГЛАВНАЯ ФУНКЦИЯ =====================
 int main() {
     // Настройка локали
@@ -263,6 +616,11 @@ int main() {
     test_decrypt();
     test_edge_cases();
     test_integration();
+    test_try_api();
+    test_arena();
+    test_preserving();
+    test_analysis();
+    test_profile();
     
     // Итоги
     cout << "\n" << string(70, '=') << endl;
@@ -0,0 +1,111 @@
+#pragma once
+#include <string>
+#include "routeCipher.h"
+#include "../common/cipherProfile.h"
+
+// routeCipher с числом столбцов, известным при компиляции.
+// Шаг по строке таблицы - константа, деление на Cols для степеней двойки
+// сводится к сдвигу, а цикл по столбцам развернут шаблонной рекурсией:
+// для каждого столбца начало и шаг чтения известны компилятору, и короткие
+// сообщения переставляются без циклов по таблице. Таблица не строится,
+// буквы копируются сразу в результат.
+// Проверка входа, ошибки и потокобезопасность те же, что у routeCipher.
+
+// Столбцы J, J-1, ..., 0 таблицы с Cols столбцами
+template <int Cols, int J>
+struct fixedRouteColumns {
+    // Шифрование: столбцы справа налево, каждый сверху вниз
+    static void gather(const wchar_t* in, wchar_t* out, int rows, int lastRow)
+    {
+        const int h = J < lastRow ? rows : rows - 1;
+        for (int i = 0; i < h; i++) {
+            out[i] = in[i * Cols + J];
+        }
+        fixedRouteColumns<Cols, J - 1>::gather(in, out + h, rows, lastRow);
+    }
+
+    // Расшифрование: обратная раскладка по тем же позициям
+    static void scatter(const wchar_t* in, wchar_t* out, int rows, int lastRow)
+    {
+        const int h = J < lastRow ? rows : rows - 1;
+        for (int i = 0; i < h; i++) {
+            out[i * Cols + J] = in[i];
+        }
+        fixedRouteColumns<Cols, J - 1>::scatter(in + h, out, rows, lastRow);
+    }
+};
+
+template <int Cols>
+struct fixedRouteColumns<Cols, -1> {
+    static void gather(const wchar_t*, wchar_t*, int, int) {}
+    static void scatter(const wchar_t*, wchar_t*, int, int) {}
+};
+
+template <int Cols>
+class fixedRouteCipher
+{
+    static_assert(Cols > 0, "Number of columns must be positive");
+    static_assert(Cols <= 100, "Number of columns is too large"); // как в routeCipher
+
+public:
+    static constexpr int columns = Cols;
+
+    // Геометрия таблицы, как в routeLayout, но с константным делителем
+    static constexpr int rows(int length) { return (length + Cols - 1) / Cols; }
+    static constexpr int lastRow(int length) { return length - (rows(length) - 1) * Cols; }
+
+    std::wstring encrypt(const std::wstring& text) const
+    {
+        routeResult r = tryEncrypt(text);
+        if (r.status == routeStatus::emptyText) {
+            throw route_cipher_error("Empty open text");
+        }
+        if (!r) {
+            throw route_cipher_error(statusMessage(r.status));
+        }
+        return r.text;
+    }
+
+    std::wstring decrypt(const std::wstring& text) const
+    {
+        routeResult r = tryDecrypt(text);
+        if (r.status == routeStatus::emptyText) {
+            throw route_cipher_error("Empty cipher text");
+        }
+        if (!r) {
+            throw route_cipher_error(statusMessage(r.status));
+        }
+        return r.text;
+    }
+
+    routeResult tryEncrypt(const std::wstring& text) const
+    {
+        routeResult r;
+        std::wstring prepared;
+        r.status = checkRouteOpenText(text, prepared, r.position);
+        if (!r) {
+            return r;
+        }
+        const int length = prepared.size();
+        CIPHER_STAGE(transform, length * sizeof(wchar_t));
+        r.text.resize(length);
+        fixedRouteColumns<Cols, Cols - 1>::gather(prepared.data(), &r.text[0],
+                                                  rows(length), lastRow(length));
+        return r;
+    }
+
+    routeResult tryDecrypt(const std::wstring& text) const
+    {
+        routeResult r;
+        r.status = checkRouteCipherText(text, r.position);
+        if (!r) {
+            return r;
+        }
+        const int length = text.size();
+        CIPHER_STAGE(transform, length * sizeof(wchar_t));
+        r.text.resize(length);
+        fixedRouteColumns<Cols, Cols - 1>::scatter(text.data(), &r.text[0],
+                                                   rows(length), lastRow(length));
+        return r;
+    }
+};
@@ -0,0 +1,97 @@
+#include "routeBatch.h"
+#include "routeCipher.h"
+#include "../common/cipherProfile.h"
+#include <algorithm>
+
+namespace {
+
+// Записей в блоке: блок входа и выхода для записей в сотни букв помещается в L1/L2
+const size_t blockRecords = 16;
+
+}
+
+routeBatch::routeBatch(int cols, int record_length) :
+    length(record_length)
+{
+    routeCipher cipher(cols); // те же проверки числа столбцов
+    if (record_length <= 0) {
+        throw route_cipher_error("Record length must be positive");
+    }
+    encryptMap = cipher.permutation(length);
+    decryptMap.resize(length);
+    for (int k = 0; k < length; k++) {
+        decryptMap[encryptMap[k]] = k;
+    }
+}
+
+// Скалярный сбор. Вариант с транспонированием блока в [k][b] векторизуется,
+// но на batch_bench (128 букв, -O3) медленнее: три прохода по блоку вместо
+// одного, а сбор и так упирается в память.
+void routeBatch::gather(const std::vector<int>& map, const wchar_t* in, wchar_t* out, size_t count) const
+{
+    CIPHER_STAGE(transform, count * length * sizeof(wchar_t));
+    const int* m = map.data();
+    const size_t n = length;
+    size_t r = 0;
+    for (; r + blockRecords <= count; r += blockRecords) {
+        const wchar_t* src = in + r * n;
+        wchar_t* dst = out + r * n;
+        for (size_t k = 0; k < n; k++) {
+            const size_t from = m[k];
+            for (size_t b = 0; b < blockRecords; b++) {
+                dst[b * n + k] = src[b * n + from];
+            }
+        }
+    }
+    for (; r < count; r++) {
+        const wchar_t* src = in + r * n;
+        wchar_t* dst = out + r * n;
+        for (size_t k = 0; k < n; k++) {
+            dst[k] = src[m[k]];
+        }
+    }
+}
+
+void routeBatch::encrypt(const wchar_t* in, wchar_t* out, size_t count) const
+{
+    gather(encryptMap, in, out, count);
+}
+
+void routeBatch::decrypt(const wchar_t* in, wchar_t* out, size_t count) const
+{
+    gather(decryptMap, in, out, count);
+}
+
+// Все символы - буквы, для шифротекста еще и заглавные; иначе ошибка с номером записи
+void routeBatch::validate(const std::wstring& records, bool upper) const
+{
+    CIPHER_STAGE(validate, records.size() * sizeof(wchar_t));
+    if (records.size() % length != 0) {
+        throw route_cipher_error("Batch size is not a multiple of record length");
+    }
+    const std::ctype<wchar_t>& ct = std::use_facet<std::ctype<wchar_t>>(routeLocale());
+    for (size_t i = 0; i < records.size(); i++) {
+        wchar_t c = records[i];
+        if (!ct.is(std::ctype_base::alpha, c) || (upper && !ct.is(std::ctype_base::upper, c))) {
+            throw route_cipher_error("Invalid letter in record " + std::to_string(i / length));
+        }
+    }
+}
+
+std::wstring routeBatch::encrypt(const std::wstring& records) const
+{
+    validate(records, false);
+    std::wstring out(records.size(), L' ');
+    encrypt(records.data(), &out[0], records.size() / length);
+    const std::ctype<wchar_t>& ct = std::use_facet<std::ctype<wchar_t>>(routeLocale());
+    ct.toupper(&out[0], &out[0] + out.size());
+    return out;
+}
+
+std::wstring routeBatch::decrypt(const std::wstring& records) const
+{
+    validate(records, true);
+    std::wstring out(records.size(), L' ');
+    decrypt(records.data(), &out[0], records.size() / length);
+    return out;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Пакетное шифрование routeCipher для записей одинаковой длины.
+// Перестановка для (length, columns) считается один раз в конструкторе,
+// затем применяется ко всем записям, лежащим подряд в одном буфере.
+// Записи обрабатываются блоками: номер исходной буквы загружается один раз
+// на блок и применяется ко всем записям блока с постоянным шагом length.
+// Сам сбор остается скалярным: косвенный индекс map[k] компилятор не
+// векторизует (-fopt-info-vec: possible alias involving gather/scatter).
+// Выигрыш пакета - одна перестановка и одна проверка на весь буфер вместо
+// таблицы и строк на каждую запись, а не SIMD.
+class routeBatch
+{
+private:
+    int length;
+    std::vector<int> encryptMap; // выход[k] = вход[encryptMap[k]]
+    std::vector<int> decryptMap; // обратная перестановка
+    void gather(const std::vector<int>& map, const wchar_t* in, wchar_t* out, size_t count) const;
+    void validate(const std::wstring& records, bool upper) const;
+
+public:
+    routeBatch() = delete;
+    routeBatch(int cols, int record_length);
+    int recordLength() const { return length; }
+
+    // Сырые буферы count * length символов без проверок; in и out не пересекаются
+    void encrypt(const wchar_t* in, wchar_t* out, size_t count) const;
+    void decrypt(const wchar_t* in, wchar_t* out, size_t count) const;
+
+    // Записи подряд в одной строке; результат - одна строка-арена того же размера.
+    // encrypt принимает буквы в любом регистре, decrypt - только заглавные.
+    std::wstring encrypt(const std::wstring& records) const;
+    std::wstring decrypt(const std::wstring& records) const;
+};
@@ -1,4 +1,5 @@
 #include "routeCipher.h"
+#include "../common/cipherProfile.h"
 #include <algorithm>
 #include <cctype>
 #include <locale>
@@ -11,7 +12,7 @@ routeCipher::routeCipher(int cols)
 }
 
 // Валидация количества столбцов
-void routeCipher::validateColumns(int cols)
+void routeCipher::validateColumns(int cols) const
 {
     if (cols <= 0) {
         throw route_cipher_error("Number of columns must be positive");
@@ -21,65 +22,86 @@ void routeCipher::validateColumns(int cols)
     }
 }
 
-// Валидация открытого текста
-std::wstring routeCipher::getValidOpenText(const std::wstring& s)
+// Локаль создается один раз: конструирование именованной локали дорогое
+const std::locale& routeLocale()
 {
+    static const std::locale loc("ru_RU.UTF-8");
+    return loc;
+}
+
+const char* statusMessage(routeStatus status)
+{
+    switch (status) {
+    case routeStatus::ok:
+        return "Ok";
+    case routeStatus::emptyText:
+        return "Empty text";
+    case routeStatus::noLetters:
+        return "Open text contains no valid letters";
+    case routeStatus::notLetter:
+        return "Cipher text must contain only letters";
+    case routeStatus::notUppercase:
+        return "Cipher text must be in uppercase";
+    }
+    return "Unknown error";
+}
+
+// Валидация открытого текста: буквы приводятся к верхнему регистру,
+// пробелы, цифры и знаки препинания отбрасываются
+template <class String>
+routeStatus checkRouteOpenText(std::wstring_view s, String& out, size_t& pos)
+{
+    CIPHER_STAGE(validate, s.size() * sizeof(wchar_t));
     if (s.empty()) {
-        throw route_cipher_error("Empty open text");
+        pos = 0;
+        return routeStatus::emptyText;
     }
     
-    std::wstring result;
-    std::locale loc("ru_RU.UTF-8");
-    
+    const std::ctype<wchar_t>& ct = std::use_facet<std::ctype<wchar_t>>(routeLocale());
+    out.reserve(s.size());
     for (wchar_t c : s) {
-        if (isalpha(c, loc) || c == L' ') {
-            if (isalpha(c, loc)) {
-                c = toupper(c, loc);
-            }
-            result += c;
-        }
-        // Игнорируем другие символы (цифры, знаки препинания)
-    }
-    
-    // Удаляем пробелы для шифрования
-    std::wstring textWithoutSpaces;
-    for (wchar_t c : result) {
-        if (c != L' ') {
-            textWithoutSpaces += c;
+        if (ct.is(std::ctype_base::alpha, c)) {
+            out += ct.toupper(c);
         }
     }
     
-    if (textWithoutSpaces.empty()) {
-        throw route_cipher_error("Open text contains no valid letters");
+    if (out.empty()) {
+        pos = s.size();
+        return routeStatus::noLetters;
     }
-    
-    return textWithoutSpaces;
+    return routeStatus::ok;
 }
 
+template routeStatus checkRouteOpenText(std::wstring_view, std::wstring&, size_t&);
+template routeStatus checkRouteOpenText(std::wstring_view, std::pmr::wstring&, size_t&);
+
 // Валидация зашифрованного текста
-std::wstring routeCipher::getValidCipherText(const std::wstring& s)
+routeStatus checkRouteCipherText(std::wstring_view s, size_t& pos)
 {
+    CIPHER_STAGE(validate, s.size() * sizeof(wchar_t));
     if (s.empty()) {
-        throw route_cipher_error("Empty cipher text");
+        pos = 0;
+        return routeStatus::emptyText;
     }
     
-    std::locale loc("ru_RU.UTF-8");
-    for (wchar_t c : s) {
-        if (!isalpha(c, loc)) {
-            throw route_cipher_error("Cipher text must contain only letters");
+    const std::ctype<wchar_t>& ct = std::use_facet<std::ctype<wchar_t>>(routeLocale());
+    for (size_t i = 0; i < s.size(); i++) {
+        if (!ct.is(std::ctype_base::alpha, s[i])) {
+            pos = i;
+            return routeStatus::notLetter;
         }
-        if (!isupper(c, loc)) {
-            throw route_cipher_error("Cipher text must be in uppercase");
+        if (!ct.is(std::ctype_base::upper, s[i])) {
+            pos = i;
+            return routeStatus::notUppercase;
         }
     }
-    
-    return s;
+    return routeStatus::ok;
 }
 
-std::wstring routeCipher::prepareText(const std::wstring& text)
+std::wstring routeCipher::prepareText(const std::wstring& text) const
 {
     std::wstring result;
-    std::locale loc("ru_RU.UTF-8");
+    const std::locale& loc = routeLocale();
     
     for (wchar_t c : text) {
         if (c != L' ') {
@@ -90,11 +112,13 @@ std::wstring routeCipher::prepareText(const std::wstring& text)
     return result;
 }
 
-std::vector<std::vector<wchar_t>> routeCipher::createTable(const std::wstring& text, int cols)
+template <class String>
+void routeCipher::createTable(std::wstring_view text, int cols, routeTable<String>& table) const
 {
     int length = text.length();
     int rows = (length + cols - 1) / cols;
-    std::vector<std::vector<wchar_t>> table(rows, std::vector<wchar_t>(cols, L' '));
+    CIPHER_STAGE(transform, text.size() * sizeof(wchar_t));
+    table.assign(rows, arenaVector<String, wchar_t>(cols, L' ', table.get_allocator()));
 
     int index = 0;
     for (int i = 0; i < rows; i++) {
@@ -104,73 +128,310 @@ std::vector<std::vector<wchar_t>> routeCipher::createTable(const std::wstring& t
             }
         }
     }
-    return table;
 }
 
-std::wstring routeCipher::readEncrypted(const std::vector<std::vector<wchar_t>>& table, int cols)
+template <class String>
+void routeCipher::readEncrypted(const routeTable<String>& table, int cols, String& out) const
 {
     int rows = table.size();
-    std::wstring result;
+    CIPHER_STAGE(output, rows * cols * sizeof(wchar_t));
+    out.reserve(rows * cols);
     for (int j = cols - 1; j >= 0; j--) {
         for (int i = 0; i < rows; i++) {
             if (table[i][j] != L' ') {
-                result += table[i][j];
+                out += table[i][j];
             }
         }
     }
-    return result;
 }
 
-std::wstring routeCipher::readDecrypted(const std::vector<std::vector<wchar_t>>& table, int cols)
+template <class String>
+void routeCipher::readDecrypted(const routeTable<String>& table, int cols, String& out) const
 {
     int rows = table.size();
-    std::wstring result;
+    CIPHER_STAGE(output, rows * cols * sizeof(wchar_t));
+    out.reserve(rows * cols);
     for (int i = 0; i < rows; i++) {
         for (int j = 0; j < cols; j++) {
             if (table[i][j] != L' ') {
-                result += table[i][j];
+                out += table[i][j];
             }
         }
     }
+}
+
+static void throwEncryptError(routeStatus status)
+{
+    if (status == routeStatus::emptyText) {
+        throw route_cipher_error("Empty open text");
+    }
+    throw route_cipher_error(statusMessage(status));
+}
+
+static void throwDecryptError(routeStatus status)
+{
+    if (status == routeStatus::emptyText) {
+        throw route_cipher_error("Empty cipher text");
+    }
+    throw route_cipher_error(statusMessage(status));
+}
+
+std::wstring routeCipher::encrypt(const std::wstring& text) const
+{
+    routeResult r = tryEncrypt(text);
+    if (!r) {
+        throwEncryptError(r.status);
+    }
+    return r.text;
+}
+
+std::wstring routeCipher::decrypt(const std::wstring& text) const
+{
+    routeResult r = tryDecrypt(text);
+    if (!r) {
+        throwDecryptError(r.status);
+    }
+    return r.text;
+}
+
+std::pmr::wstring routeCipher::encrypt(std::wstring_view text, std::pmr::memory_resource* resource) const
+{
+    std::pmr::wstring result(resource);
+    size_t pos = 0;
+    routeStatus status = encryptTo(text, result, pos);
+    if (status != routeStatus::ok) {
+        throwEncryptError(status);
+    }
     return result;
 }
 
-std::wstring routeCipher::encrypt(const std::wstring& text)
+std::pmr::wstring routeCipher::decrypt(std::wstring_view text, std::pmr::memory_resource* resource) const
 {
-    std::wstring prepared = getValidOpenText(text);
-    auto table = createTable(prepared, columns);
-    return readEncrypted(table, columns);
+    std::pmr::wstring result(resource);
+    size_t pos = 0;
+    routeStatus status = decryptTo(text, result, pos);
+    if (status != routeStatus::ok) {
+        throwDecryptError(status);
+    }
+    return result;
 }
 
-std::wstring routeCipher::decrypt(const std::wstring& text)
+routeResult routeCipher::tryEncrypt(const std::wstring& text) const
 {
-    std::wstring prepared = getValidCipherText(text);
-    int length = prepared.length();
-    
-    if (length == 0) {
-        throw route_cipher_error("Cipher text is empty after validation");
+    routeResult r;
+    r.status = encryptTo(text, r.text, r.position);
+    return r;
+}
+
+routeResult routeCipher::tryDecrypt(const std::wstring& text) const
+{
+    routeResult r;
+    r.status = decryptTo(text, r.text, r.position);
+    return r;
+}
+
+routeStatus routeCipher::tryEncrypt(std::wstring_view text, std::pmr::wstring& out, size_t& pos) const
+{
+    return encryptTo(text, out, pos);
+}
+
+routeStatus routeCipher::tryDecrypt(std::wstring_view text, std::pmr::wstring& out, size_t& pos) const
+{
+    return decryptTo(text, out, pos);
+}
+
+template <class String>
+routeStatus routeCipher::encryptTo(std::wstring_view text, String& out, size_t& pos) const
+{
+    String prepared(out.get_allocator());
+    routeStatus status = checkRouteOpenText(text, prepared, pos);
+    if (status != routeStatus::ok) {
+        return status;
     }
-    
+    routeTable<String> table(out.get_allocator());
+    createTable<String>(prepared, columns, table);
+    readEncrypted(table, columns, out);
+    return status;
+}
+
+template <class String>
+routeStatus routeCipher::decryptTo(std::wstring_view text, String& out, size_t& pos) const
+{
+    routeStatus status = checkRouteCipherText(text, pos);
+    if (status != routeStatus::ok) {
+        return status;
+    }
+    int length = text.length();
     int rows = (length + columns - 1) / columns;
+    routeTable<String> table(out.get_allocator());
+    {
+        CIPHER_STAGE(transform, text.size() * sizeof(wchar_t));
+        table.assign(rows, arenaVector<String, wchar_t>(columns, L' ', out.get_allocator()));
+        int extras = length % columns;
+        arenaVector<String, int> heights(columns, rows, out.get_allocator());
+        if (extras != 0) {
+            for (int j = 0; j < columns; ++j) {
+                heights[j] = (j < extras) ? rows : (rows - 1);
+            }
+        }
 
-    int extras = length % columns;
-    std::vector<int> heights(columns, rows);
-    if (extras != 0) {
-        for (int j = 0; j < columns; ++j) {
-            heights[j] = (j < extras) ? rows : (rows - 1);
+        int index = 0;
+        for (int j = columns - 1; j >= 0; j--) {
+            int h = heights[j];
+            for (int i = 0; i < h; i++) {
+                if (index < length) {
+                    table[i][j] = text[index++];
+                }
+            }
         }
     }
+    readDecrypted(table, columns, out);
+    return status;
+}
 
-    std::vector<std::vector<wchar_t>> table(rows, std::vector<wchar_t>(columns, L' '));
-    int index = 0;
+// Буквы собираются подряд (нужен доступ по номеру буквы), затем один проход
+// по копии входа раскладывает их по позициям букв в порядке маршрута.
+// Номер буквы вычисляется из строки и столбца таблицы, саму таблицу не строим.
+std::wstring routeCipher::encryptPreserving(const std::wstring& text) const
+{
+    CIPHER_STAGE(transform, text.size() * sizeof(wchar_t));
+    const std::ctype<wchar_t>& ct = std::use_facet<std::ctype<wchar_t>>(routeLocale());
+    std::wstring letters;
+    letters.reserve(text.size());
+    for (wchar_t c : text) {
+        if (ct.is(std::ctype_base::alpha, c)) {
+            letters += c;
+        }
+    }
+    std::wstring result(text);
+    if (letters.empty()) {
+        return result;
+    }
+
+    const routeLayout layout(letters.size(), columns);
+    int j = columns - 1;
+    int i = 0;
+    for (auto& c : result) {
+        if (!ct.is(std::ctype_base::alpha, c)) {
+            continue;
+        }
+        while (i >= layout.height(j)) {
+            j--;
+            i = 0;
+        }
+        c = letters[i * columns + j];
+        i++;
+    }
+    return result;
+}
+
+std::wstring routeCipher::decryptPreserving(const std::wstring& text) const
+{
+    CIPHER_STAGE(transform, text.size() * sizeof(wchar_t));
+    const std::ctype<wchar_t>& ct = std::use_facet<std::ctype<wchar_t>>(routeLocale());
+    std::wstring letters;
+    letters.reserve(text.size());
+    for (wchar_t c : text) {
+        if (ct.is(std::ctype_base::alpha, c)) {
+            letters += c;
+        }
+    }
+    std::wstring result(text);
+    if (letters.empty()) {
+        return result;
+    }
+
+    const routeLayout layout(letters.size(), columns);
+    int i = 0; // строка и столбец очередной буквы открытого текста
+    int j = 0;
+    for (auto& c : result) {
+        if (!ct.is(std::ctype_base::alpha, c)) {
+            continue;
+        }
+        c = letters[layout.columnStart(j) + i];
+        if (++j == columns) {
+            j = 0;
+            i++;
+        }
+    }
+    return result;
+}
 
+std::vector<int> routeCipher::permutation(int length) const
+{
+    std::vector<int> perm(length);
+    if (length == 0) {
+        return perm;
+    }
+    const routeLayout layout(length, columns);
+    int k = 0;
     for (int j = columns - 1; j >= 0; j--) {
-        int h = heights[j];
-        for (int i = 0; i < h; i++) {
-            if (index < length) {
-                table[i][j] = prepared[index++];
+        for (int i = 0; i < layout.height(j); i++) {
+            perm[k++] = i * columns + j;
+        }
+    }
+    return perm;
+}
+
+// Степени одной перестановки коммутируют, поэтому порядок умножения не важен
+std::vector<int> routeCipher::power(const std::vector<int>& perm, unsigned long long rounds)
+{
+    const size_t n = perm.size();
+    std::vector<int> result(n);
+    for (size_t t = 0; t < n; t++) {
+        result[t] = t;
+    }
+    std::vector<int> base(perm);
+    std::vector<int> tmp(n);
+    while (rounds) {
+        if (rounds & 1) {
+            for (size_t t = 0; t < n; t++) {
+                tmp[t] = base[result[t]];
+            }
+            result.swap(tmp);
+        }
+        rounds >>= 1;
+        if (rounds) {
+            for (size_t t = 0; t < n; t++) {
+                tmp[t] = base[base[t]];
             }
+            base.swap(tmp);
         }
     }
-    return readDecrypted(table, columns);
-}
\ No newline at end of file
+    return result;
+}
+
+std::wstring routeCipher::encryptRounds(const std::wstring& text, unsigned long long rounds) const
+{
+    std::wstring prepared;
+    size_t pos = 0;
+    routeStatus status = checkRouteOpenText(text, prepared, pos);
+    if (status != routeStatus::ok) {
+        throwEncryptError(status);
+    }
+
+    CIPHER_STAGE(transform, prepared.size() * sizeof(wchar_t));
+    std::vector<int> perm = power(permutation(prepared.size()), rounds);
+    std::wstring result(prepared.size(), L' ');
+    for (size_t k = 0; k < perm.size(); k++) {
+        result[k] = prepared[perm[k]];
+    }
+    return result;
+}
+
+std::wstring routeCipher::decryptRounds(const std::wstring& text, unsigned long long rounds) const
+{
+    size_t pos = 0;
+    routeStatus status = checkRouteCipherText(text, pos);
+    if (status != routeStatus::ok) {
+        throwDecryptError(status);
+    }
+
+    CIPHER_STAGE(transform, text.size() * sizeof(wchar_t));
+    std::vector<int> perm = power(permutation(text.size()), rounds);
+    std::wstring result(text.size(), L' ');
+    for (size_t k = 0; k < perm.size(); k++) {
+        result[perm[k]] = text[k];
+    }
+    return result;
+}
@@ -3,6 +3,9 @@
 #include <string>
 #include <stdexcept>
 #include <locale>
+#include <memory_resource>
+#include <string_view>
+#include "../common/arena.h"
 
 class route_cipher_error : public std::invalid_argument {
 public:
@@ -12,25 +15,106 @@ public:
         std::invalid_argument(what_arg) {}
 };
 
+// Результат проверки и шифрования без исключений
+enum class routeStatus {
+    ok,
+    emptyText,     // пустая входная строка
+    noLetters,     // в открытом тексте нет букв
+    notLetter,     // в шифротексте есть не-буква
+    notUppercase   // в шифротексте есть строчная буква
+};
+
+struct routeResult {
+    routeStatus status = routeStatus::ok;
+    size_t position = 0; // индекс первого ошибочного символа во входной строке
+    std::wstring text;
+    explicit operator bool() const { return status == routeStatus::ok; }
+};
+
+const char* statusMessage(routeStatus status);
+
+// Локаль ru_RU.UTF-8, по которой routeCipher определяет буквы и регистр
+const std::locale& routeLocale();
+
+// Проверка входа, общая для routeCipher и fixedRouteCipher.
+// Открытый текст: буквы приводятся к верхнему регистру и собираются в out
+// (std::wstring или std::pmr::wstring).
+template <class String>
+routeStatus checkRouteOpenText(std::wstring_view s, String& out, size_t& pos);
+extern template routeStatus checkRouteOpenText(std::wstring_view, std::wstring&, size_t&);
+extern template routeStatus checkRouteOpenText(std::wstring_view, std::pmr::wstring&, size_t&);
+// Шифротекст: только заглавные буквы
+routeStatus checkRouteCipherText(std::wstring_view s, size_t& pos);
+
+// Таблица маршрута, строки которой берут распределитель у строки String
+template <class String>
+using routeTable = arenaVector<String, arenaVector<String, wchar_t>>;
+
+// Геометрия таблицы маршрута для текста из length букв: строки заполняются
+// слева направо, шифротекст читается по столбцам справа налево, сверху вниз.
+// Позволяет переводить номера букв без построения самой таблицы.
+struct routeLayout {
+    int columns;
+    int rows;
+    int lastRow; // букв в последней строке
+
+    routeLayout(int length, int cols) :
+        columns(cols),
+        rows((length + cols - 1) / cols),
+        lastRow(length - (rows - 1) * cols) {}
+
+    int height(int j) const { return j < lastRow ? rows : rows - 1; }
+
+    // Начало столбца j в шифротексте: сумма высот столбцов правее него
+    int columnStart(int j) const
+    {
+        int shorter = columns - 1 - (j > lastRow - 1 ? j : lastRow - 1);
+        return (columns - 1 - j) * rows - (shorter > 0 ? shorter : 0);
+    }
+};
+
+// Маршрутная перестановка: запись по строкам, чтение по столбцам справа налево.
+// Методы шифрования не меняют объект, поэтому один экземпляр можно делить между
+// потоками. encrypt/decrypt бросают route_cipher_error, tryEncrypt/tryDecrypt
+// возвращают ту же ошибку входа статусом и позицией символа. Перегрузки с pmr
+// берут результат, таблицу и временные буферы из переданного распределителя.
 class routeCipher
 {
 private:
     int columns;
 
-    std::wstring prepareText(const std::wstring& text);
-    std::vector<std::vector<wchar_t>> createTable(const std::wstring& text, int cols);
-    std::wstring readEncrypted(const std::vector<std::vector<wchar_t>>& table, int cols);
-    std::wstring readDecrypted(const std::vector<std::vector<wchar_t>>& table, int cols);
+    std::wstring prepareText(const std::wstring& text) const;
+    template <class String> void createTable(std::wstring_view text, int cols, routeTable<String>& table) const;
+    template <class String> void readEncrypted(const routeTable<String>& table, int cols, String& out) const;
+    template <class String> void readDecrypted(const routeTable<String>& table, int cols, String& out) const;
+    template <class String> routeStatus encryptTo(std::wstring_view text, String& out, size_t& pos) const;
+    template <class String> routeStatus decryptTo(std::wstring_view text, String& out, size_t& pos) const;
     
     // Методы валидации
-    void validateColumns(int cols);
-    std::wstring getValidOpenText(const std::wstring& s);
-    std::wstring getValidCipherText(const std::wstring& s);
+    void validateColumns(int cols) const;
 
 public:
     routeCipher() = delete;
     routeCipher(int cols);
 
-    std::wstring encrypt(const std::wstring& text);
-    std::wstring decrypt(const std::wstring& text);
-};
\ No newline at end of file
+    std::wstring encrypt(const std::wstring& text) const;
+    std::wstring decrypt(const std::wstring& text) const;
+    routeResult tryEncrypt(const std::wstring& text) const;
+    routeResult tryDecrypt(const std::wstring& text) const;
+    std::pmr::wstring encrypt(std::wstring_view text, std::pmr::memory_resource* resource) const;
+    std::pmr::wstring decrypt(std::wstring_view text, std::pmr::memory_resource* resource) const;
+    routeStatus tryEncrypt(std::wstring_view text, std::pmr::wstring& out, size_t& pos) const;
+    routeStatus tryDecrypt(std::wstring_view text, std::pmr::wstring& out, size_t& pos) const;
+    // Режим с сохранением формата: переставляются только буквы, остальные
+    // символы остаются на своих местах. Ошибок входа нет.
+    std::wstring encryptPreserving(const std::wstring& text) const;
+    std::wstring decryptPreserving(const std::wstring& text) const;
+
+    // Перестановка одного раунда для текста из length букв: шифротекст[k] = текст[perm[k]]
+    std::vector<int> permutation(int length) const;
+    // Степень перестановки возведением в квадрат: O(length * log rounds)
+    static std::vector<int> power(const std::vector<int>& perm, unsigned long long rounds);
+    // rounds раундов подряд: перестановка возводится в степень и применяется за один проход
+    std::wstring encryptRounds(const std::wstring& text, unsigned long long rounds) const;
+    std::wstring decryptRounds(const std::wstring& text, unsigned long long rounds) const;
+};
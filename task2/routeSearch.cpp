@@ -0,0 +1,149 @@
+#include "routeSearch.h"
+#include "routeCipher.h"
+#include "../common/parallel.h"
+#include <algorithm>
+#include <cmath>
+
+letterNgramModel::letterNgramModel(const std::wstring& corpus, int order, const std::wstring& letters) :
+    n(order), alphabet(letters)
+{
+    if (n < 1 || n > maxOrder) {
+        throw route_cipher_error("Unsupported n-gram order");
+    }
+    if (alphabet.empty()) {
+        throw route_cipher_error("Empty model alphabet");
+    }
+    low = *std::min_element(alphabet.begin(), alphabet.end());
+    wchar_t high = *std::max_element(alphabet.begin(), alphabet.end());
+    index.assign(high - low + 1, -1);
+    for (size_t i = 0; i < alphabet.size(); i++) {
+        index[alphabet[i] - low] = i;
+    }
+
+    size_t cells = 1;
+    for (int i = 0; i < n; i++) {
+        cells *= alphabet.size();
+        if (cells > (1u << 24)) {
+            throw route_cipher_error("N-gram table is too large");
+        }
+    }
+    std::vector<unsigned> counts(cells, 0);
+    size_t total = 0;
+    size_t code = 0;
+    int filled = 0;
+    const std::ctype<wchar_t>& ct = std::use_facet<std::ctype<wchar_t>>(routeLocale());
+    for (wchar_t c : corpus) {
+        c = ct.toupper(c);
+        if (c < low || c - low >= static_cast<int>(index.size()) || index[c - low] < 0) {
+            continue;
+        }
+        code = (code * alphabet.size() + index[c - low]) % cells;
+        if (++filled >= n) {
+            counts[code]++;
+            total++;
+        }
+    }
+
+    table.resize(cells);
+    double denominator = std::log(static_cast<double>(total + cells));
+    for (size_t i = 0; i < cells; i++) {
+        table[i] = std::log(counts[i] + 1.0) - denominator;
+    }
+    floor = -denominator - std::log(static_cast<double>(alphabet.size()));
+}
+
+double letterNgramModel::score(const wchar_t* gram) const
+{
+    size_t code = 0;
+    for (int i = 0; i < n; i++) {
+        wchar_t c = gram[i];
+        if (c < low || c - low >= static_cast<int>(index.size()) || index[c - low] < 0) {
+            return floor;
+        }
+        code = code * alphabet.size() + index[c - low];
+    }
+    return table[code];
+}
+
+routeSearch::routeSearch(const std::wstring& cipher_text, unsigned thread_count) :
+    threads(thread_count)
+{
+    const std::ctype<wchar_t>& ct = std::use_facet<std::ctype<wchar_t>>(routeLocale());
+    text.reserve(cipher_text.size());
+    for (wchar_t c : cipher_text) {
+        if (ct.is(std::ctype_base::alpha, c)) {
+            text += ct.toupper(c);
+        }
+    }
+}
+
+double routeSearch::scoreColumns(int columns, const ngramModel& model) const
+{
+    const int n = model.order();
+    const int length = text.size();
+    if (columns < 1) {
+        throw route_cipher_error("Number of columns must be positive");
+    }
+    if (n < 1 || n > ngramModel::maxOrder) {
+        throw route_cipher_error("Unsupported n-gram order");
+    }
+    if (length < n) {
+        return 0;
+    }
+
+    const routeLayout layout(length, std::min(columns, length));
+    wchar_t gram[ngramModel::maxOrder] = {};
+    double sum = 0;
+    int i = 0; // строка и столбец очередной буквы открытого текста
+    int j = 0;
+    for (int t = 0; t < length; t++) {
+        std::copy(gram + 1, gram + n, gram);
+        gram[n - 1] = text[layout.columnStart(j) + i];
+        if (t >= n - 1) {
+            sum += model.score(gram);
+        }
+        if (++j == layout.columns) {
+            j = 0;
+            i++;
+        }
+    }
+    return sum / (length - n + 1);
+}
+
+std::vector<routeCandidate> routeSearch::search(const ngramModel& model, int maxColumns, size_t k) const
+{
+    maxColumns = std::min<long long>(maxColumns, text.size());
+    if (maxColumns < 1) {
+        throw route_cipher_error("Nothing to search");
+    }
+    std::vector<routeCandidate> candidates(maxColumns);
+    parallelFor(maxColumns, threads, [&](size_t c) {
+        candidates[c].columns = c + 1;
+        candidates[c].score = scoreColumns(c + 1, model);
+    });
+
+    k = std::min(k, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + k, candidates.end(),
+        [](const routeCandidate& a, const routeCandidate& b) {
+            return a.score != b.score ? a.score > b.score : a.columns < b.columns;
+        });
+    candidates.resize(k);
+    return candidates;
+}
+
+std::wstring routeSearch::candidateText(int columns) const
+{
+    if (columns < 1) {
+        throw route_cipher_error("Number of columns must be positive");
+    }
+    const int length = text.size();
+    std::wstring result(length, L' ');
+    if (length == 0) {
+        return result;
+    }
+    const routeLayout layout(length, std::min(columns, length));
+    for (int t = 0; t < length; t++) {
+        result[t] = text[layout.columnStart(t % layout.columns) + t / layout.columns];
+    }
+    return result;
+}
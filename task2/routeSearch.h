@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Языковая модель для оценки кандидатов: логарифм вероятности n-граммы.
+// Реализации должны допускать одновременные вызовы score из разных потоков.
+class ngramModel
+{
+public:
+    virtual ~ngramModel() {}
+    virtual int order() const = 0; // n, не больше maxOrder
+    virtual double score(const wchar_t* gram) const = 0; // gram[0..order()-1], буквы в верхнем регистре
+
+    static const int maxOrder = 8;
+};
+
+// Модель буквенных n-грамм, обученная на образце текста (сглаживание добавлением единицы).
+// Буквы вне алфавита при обучении пропускаются, при оценке получают минимальный балл.
+class letterNgramModel : public ngramModel
+{
+private:
+    int n;
+    std::wstring alphabet;
+    wchar_t low;
+    std::vector<int> index;    // символ - low -> номер в алфавите или -1
+    std::vector<double> table; // алфавит^n логарифмов вероятностей
+    double floor;
+
+public:
+    letterNgramModel() = delete;
+    letterNgramModel(const std::wstring& corpus, int order = 2,
+                     const std::wstring& letters = L"АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ");
+    int order() const override { return n; }
+    double score(const wchar_t* gram) const override;
+};
+
+struct routeCandidate {
+    int columns;
+    double score; // средний балл n-граммы, больше - правдоподобнее
+};
+
+// Перебор числа столбцов для шифротекста routeCipher.
+// Кандидат оценивается без расшифрования: буква открытого текста берется
+// из шифротекста по вычисленному номеру (routeLayout), без таблиц и выделений памяти.
+// Число столбцов не ограничено пределом routeCipher в 100.
+class routeSearch
+{
+private:
+    std::wstring text; // буквы шифротекста в верхнем регистре
+    unsigned threads;
+
+public:
+    routeSearch() = delete;
+    // threads = 0 - по числу ядер
+    explicit routeSearch(const std::wstring& cipher_text, unsigned thread_count = 0);
+    size_t size() const { return text.size(); }
+
+    double scoreColumns(int columns, const ngramModel& model) const;
+    // k лучших кандидатов среди 1..maxColumns, по убыванию балла
+    std::vector<routeCandidate> search(const ngramModel& model, int maxColumns, size_t k = 5) const;
+    std::wstring candidateText(int columns) const;
+};
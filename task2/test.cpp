@@ -1,7 +1,13 @@
 #include <iostream>
 #include <locale>
 #include <string>
+#include <thread>
+#include <memory_resource>
 #include "routeCipher.h"
+#include "routeSearch.h"
+#include "routeBatch.h"
+#include "fixedRouteCipher.h"
+#include "../common/cipherProfile.h"
 
 using namespace std;
 
@@ -315,6 +321,494 @@ void test_integration() {
     }(), "Encrypt/decrypt - обратные операции для разных текстов");
 }
 
+// ===================== ТЕСТЫ API БЕЗ ИСКЛЮЧЕНИЙ =====================
+void test_try_api() {
+    print_section("ТЕСТЫ API БЕЗ ИСКЛЮЧЕНИЙ");
+    
+    // Успешный результат совпадает с encrypt/decrypt
+    assert_true([]() {
+        routeCipher cipher(4);
+        routeResult enc = cipher.tryEncrypt(L"Привет, мир!");
+        routeResult dec = cipher.tryDecrypt(enc.text);
+        return enc && dec && enc.text == cipher.encrypt(L"ПРИВЕТМИР") && dec.text == L"ПРИВЕТМИР";
+    }(), "tryEncrypt/tryDecrypt совпадают с encrypt/decrypt");
+    
+    // Пустой текст
+    assert_true([]() {
+        routeCipher cipher(3);
+        return cipher.tryEncrypt(L"").status == routeStatus::emptyText
+            && cipher.tryDecrypt(L"").status == routeStatus::emptyText;
+    }(), "Пустой текст");
+    
+    // Открытый текст без букв
+    assert_true([]() {
+        routeCipher cipher(3);
+        routeResult r = cipher.tryEncrypt(L"123 !@#");
+        return r.status == routeStatus::noLetters && r.position == 7 && r.text.empty();
+    }(), "tryEncrypt: текст без букв");
+    
+    // Не-буква в шифротексте
+    assert_true([]() {
+        routeCipher cipher(3);
+        routeResult r = cipher.tryDecrypt(L"ШИФР!ТЕКСТ");
+        return r.status == routeStatus::notLetter && r.position == 4;
+    }(), "tryDecrypt: позиция не-буквы");
+    
+    // Строчная буква в шифротексте
+    assert_true([]() {
+        routeCipher cipher(3);
+        routeResult r = cipher.tryDecrypt(L"ШИФРтекст");
+        return r.status == routeStatus::notUppercase && r.position == 4;
+    }(), "tryDecrypt: позиция строчной буквы");
+}
+
+// ===================== ТЕСТЫ РЕЖИМА С СОХРАНЕНИЕМ ФОРМАТА =====================
+void test_preserving() {
+    print_section("ТЕСТЫ РЕЖИМА С СОХРАНЕНИЕМ ФОРМАТА");
+    
+    // Буквы переставлены как в обычном режиме, не-буквы на месте
+    assert_true([]() {
+        for (int cols = 1; cols <= 9; cols++) {
+            routeCipher cipher(cols);
+            wstring result = cipher.encryptPreserving(L"ПРО ГРАМ-МИРО, ВАНИЕ!");
+            wstring letters;
+            for (auto c : result) {
+                if (c != L' ' && c != L'-' && c != L',' && c != L'!') {
+                    letters += c;
+                }
+            }
+            if (result.size() != 21 || result[3] != L' ' || result[8] != L'-'
+                || result.substr(13, 2) != L", " || result[20] != L'!'
+                || letters != cipher.encrypt(L"ПРОГРАММИРОВАНИЕ")) {
+                return false;
+            }
+        }
+        return true;
+    }(), "Переставляются только позиции букв");
+    
+    // Полный цикл для разных длин и числа столбцов
+    assert_true([]() {
+        wstring original = L"Съешь же ещё этих мягких французских булок, да выпей чаю.";
+        for (int cols = 1; cols <= 12; cols++) {
+            routeCipher cipher(cols);
+            for (size_t len = 0; len <= original.size(); len++) {
+                wstring text = original.substr(0, len);
+                if (cipher.decryptPreserving(cipher.encryptPreserving(text)) != text) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }(), "Полный цикл с сохранением формата");
+    
+    // Расшифрование совпадает с обычным режимом
+    assert_true([]() {
+        routeCipher cipher(5);
+        wstring encrypted = cipher.encrypt(L"ПРОГРАММИРОВАНИЕПЕНЗА");
+        return cipher.decryptPreserving(encrypted) == cipher.decrypt(encrypted);
+    }(), "decryptPreserving совпадает с decrypt на тексте без не-букв");
+    
+    // Текст без букв
+    assert_true([]() {
+        routeCipher cipher(3);
+        return cipher.encryptPreserving(L"12, 34!") == L"12, 34!";
+    }(), "Текст без букв возвращается без изменений");
+}
+
+// ===================== ТЕСТЫ МНОГОРАУНДОВОГО РЕЖИМА =====================
+void test_rounds() {
+    print_section("ТЕСТЫ МНОГОРАУНДОВОГО РЕЖИМА");
+    
+    // k раундов совпадают с k вызовами encrypt
+    assert_true([]() {
+        wstring original = L"ПРОГРАММИРОВАНИЕПЕНЗАСЪЕШЬЖЕЕЩЁЭТИХ";
+        for (int cols = 1; cols <= 9; cols++) {
+            routeCipher cipher(cols);
+            wstring repeated = cipher.encrypt(original);
+            for (unsigned k = 1; k <= 12; k++) {
+                if (cipher.encryptRounds(original, k) != repeated) {
+                    return false;
+                }
+                repeated = cipher.encrypt(repeated);
+            }
+        }
+        return true;
+    }(), "encryptRounds совпадает с повторным encrypt");
+    
+    // Обратимость при большом числе раундов
+    assert_true([]() {
+        routeCipher cipher(6);
+        wstring original = L"СЕКРЕТНОЕСООБЩЕНИЕДЛЯМНОГИХРАУНДОВ";
+        for (unsigned long long k : {0ULL, 1ULL, 7ULL, 1000ULL, 1000000000000000000ULL}) {
+            if (cipher.decryptRounds(cipher.encryptRounds(original, k), k) != original) {
+                return false;
+            }
+        }
+        return cipher.encryptRounds(L"при вет", 0) == L"ПРИВЕТ";
+    }(), "decryptRounds обратен encryptRounds");
+    
+    // Перестановка одного раунда и ее степени
+    assert_true([]() {
+        routeCipher cipher(4);
+        wstring text = L"ПРОГРАММИРОВАНИЕПЕНЗА";
+        vector<int> perm = cipher.permutation(text.size());
+        wstring gathered(text.size(), L' ');
+        for (size_t k = 0; k < perm.size(); k++) {
+            gathered[k] = text[perm[k]];
+        }
+        // Найдем порядок перестановки: ее степень с этим показателем тождественна
+        unsigned long long order = 1;
+        vector<int> p = perm;
+        while (p != routeCipher::power(perm, 0)) {
+            p = routeCipher::power(perm, ++order);
+        }
+        return gathered == cipher.encrypt(text)
+            && routeCipher::power(perm, order * 3 + 1) == perm;
+    }(), "Перестановка раунда и возведение в степень");
+    
+    assert_exception([]() {
+        routeCipher cipher(3);
+        cipher.encryptRounds(L"123", 5);
+    }, "Текст без букв");
+    
+    assert_exception([]() {
+        routeCipher cipher(3);
+        cipher.decryptRounds(L"ШИФРтекст", 5);
+    }, "Строчные буквы в шифротексте");
+}
+
+// ===================== ТЕСТЫ РАБОТЫ С АРЕНОЙ =====================
+void test_arena() {
+    print_section("ТЕСТЫ РАБОТЫ С АРЕНОЙ");
+    
+    // Совпадает с обычным API при неполной последней строке
+    assert_true([]() {
+        routeCipher cipher(4);
+        pmr::monotonic_buffer_resource arena;
+        pmr::wstring enc = cipher.encrypt(L"при вет, мир!", &arena);
+        pmr::wstring dec = cipher.decrypt(enc, &arena);
+        return enc == cipher.encrypt(L"ПРИВЕТМИР").c_str() && dec == L"ПРИВЕТМИР";
+    }(), "encrypt/decrypt с ареной совпадают с обычными");
+    
+    // Таблица и ее строки помещаются в арену без обращения к куче:
+    // у арены нет вышестоящего ресурса, выход за буфер дал бы bad_alloc
+    assert_true([]() {
+        routeCipher cipher(3);
+        wchar_t buffer[4096];
+        pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), pmr::null_memory_resource());
+        pmr::wstring enc = cipher.encrypt(L"ПРИВЕТМИРВСЕМ", &arena);
+        pmr::wstring dec = cipher.decrypt(enc, &arena);
+        return dec == L"ПРИВЕТМИРВСЕМ" && enc.get_allocator().resource() == &arena;
+    }(), "Временные буферы берутся из арены");
+    
+    assert_exception([]() {
+        routeCipher cipher(3);
+        pmr::monotonic_buffer_resource arena;
+        cipher.encrypt(L"123", &arena);
+    }, "Текст без букв с ареной");
+    
+    assert_exception([]() {
+        routeCipher cipher(3);
+        pmr::monotonic_buffer_resource arena;
+        cipher.decrypt(L"ТЕКСТ1", &arena);
+    }, "Не-буква в шифротексте с ареной");
+}
+
+// ===================== ТЕСТЫ ПАКЕТНОГО РЕЖИМА =====================
+void test_batch() {
+    print_section("ТЕСТЫ ПАКЕТНОГО РЕЖИМА");
+    
+    // Пакет совпадает с поштучным шифрованием (полные блоки и хвост)
+    assert_true([]() {
+        const wstring alphabet = L"АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ";
+        for (int cols : {1, 3, 8, 16}) {
+            for (int length : {1, 7, 128}) {
+                routeCipher cipher(cols);
+                routeBatch batch(cols, length);
+                wstring records;
+                wstring expected;
+                for (int r = 0; r < 37; r++) {
+                    wstring record;
+                    for (int i = 0; i < length; i++) {
+                        record += alphabet[(r * 7 + i * 5) % alphabet.size()];
+                    }
+                    records += record;
+                    expected += cipher.encrypt(record);
+                }
+                wstring encrypted = batch.encrypt(records);
+                if (encrypted != expected || batch.decrypt(encrypted) != records) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }(), "Пакет совпадает с поштучным шифрованием");
+    
+    // Сырые буферы
+    assert_true([]() {
+        routeBatch batch(4, 6);
+        const wstring records = L"ПРИВЕТМИРВСЕМЛЕТОЗИМА";
+        wstring in = records.substr(0, 18);
+        wstring out(18, L' ');
+        wstring back(18, L' ');
+        batch.encrypt(in.data(), &out[0], 3);
+        batch.decrypt(out.data(), &back[0], 3);
+        routeCipher cipher(4);
+        return out.substr(6, 6) == cipher.encrypt(L"МИРВСЕ") && back == in;
+    }(), "Сырые буферы");
+    
+    // Строчные буквы приводятся к верхнему регистру
+    assert_true([]() {
+        routeBatch batch(3, 5);
+        return batch.encrypt(L"текстслово") == routeBatch(3, 5).encrypt(L"ТЕКСТСЛОВО");
+    }(), "Приведение к верхнему регистру");
+    
+    assert_exception([]() {
+        routeBatch batch(3, 5);
+        batch.encrypt(L"ТЕКСТСЛОВ");
+    }, "Размер пакета не кратен длине записи");
+    
+    assert_exception([]() {
+        routeBatch batch(3, 5);
+        batch.encrypt(L"ТЕКСТСЛ1ВО");
+    }, "Не-буква в записи");
+    
+    assert_exception([]() {
+        routeBatch batch(3, 5);
+        batch.decrypt(L"ТЕКСТслово");
+    }, "Строчные буквы в шифротексте");
+    
+    assert_exception([]() {
+        routeBatch batch(101, 5);
+    }, "Неверное число столбцов");
+    
+    assert_exception([]() {
+        routeBatch batch(3, 0);
+    }, "Нулевая длина записи");
+}
+
+// ===================== ТЕСТЫ ШАБЛОННОГО ВАРИАНТА =====================
+static bool same_result(const routeResult& a, const routeResult& b) {
+    return a.status == b.status && a.position == b.position && a.text == b.text;
+}
+
+// Сравнение с routeCipher на текстах всех длин до 5 * Cols, включая ошибочные
+template <int Cols>
+static bool same_as_runtime() {
+    const wstring sample = L"ПривеТ, мир! 12 Ёжик в тумане ЪЫЬ эюя - ВСЕМ ЛЕТО ЗИМА ШИФР МАРШРУТА";
+    routeCipher runtime(Cols);
+    fixedRouteCipher<Cols> fixed;
+    for (size_t length = 0; length <= 5 * Cols && length <= sample.size(); length++) {
+        wstring text = sample.substr(0, length);
+        routeResult expected = runtime.tryEncrypt(text);
+        if (!same_result(fixed.tryEncrypt(text), expected)) {
+            return false;
+        }
+        if (!same_result(fixed.tryDecrypt(expected.text), runtime.tryDecrypt(expected.text))) {
+            return false;
+        }
+        if (!same_result(fixed.tryDecrypt(text), runtime.tryDecrypt(text))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_fixed() {
+    print_section("ТЕСТЫ ШАБЛОННОГО ВАРИАНТА");
+    
+    assert_true(same_as_runtime<1>(), "Совпадает с routeCipher при 1 столбце");
+    assert_true(same_as_runtime<4>(), "Совпадает с routeCipher при 4 столбцах");
+    assert_true(same_as_runtime<8>(), "Совпадает с routeCipher при 8 столбцах");
+    assert_true(same_as_runtime<16>(), "Совпадает с routeCipher при 16 столбцах");
+    
+    // Геометрия вычисляется при компиляции
+    assert_true([]() {
+        static_assert(fixedRouteCipher<8>::rows(17) == 3, "rows");
+        static_assert(fixedRouteCipher<8>::lastRow(17) == 1, "lastRow");
+        static_assert(fixedRouteCipher<4>::lastRow(8) == 4, "lastRow");
+        return true;
+    }(), "constexpr геометрия таблицы");
+    
+    assert_true([]() {
+        fixedRouteCipher<4> cipher;
+        return cipher.encrypt(L"ПРИВЕТМИР") == L"ВИИМРТПЕР" &&
+               cipher.decrypt(L"ВИИМРТПЕР") == L"ПРИВЕТМИР";
+    }(), "Шифрование и расшифрование");
+    
+    assert_exception([]() {
+        fixedRouteCipher<8> cipher;
+        cipher.encrypt(L"");
+    }, "Пустой открытый текст");
+    
+    assert_exception([]() {
+        fixedRouteCipher<8> cipher;
+        cipher.decrypt(L"ПРИВЕТмир");
+    }, "Строчные буквы в шифротексте");
+}
+
+// ===================== ТЕСТЫ ПЕРЕБОРА ЧИСЛА СТОЛБЦОВ =====================
+const wstring corpus =
+    L"Утром над рекой стоял густой туман, и лодки у причала казались серыми тенями. "
+    L"Старый рыбак медленно разматывал сети и рассказывал внуку, как в молодости "
+    L"уходил на озеро еще до рассвета и возвращался только к вечеру с полной лодкой. "
+    L"Мальчик слушал внимательно, хотя знал эти истории почти наизусть. Потом они "
+    L"вместе столкнули лодку в воду, и она тихо заскользила вдоль берега, где над "
+    L"водой склонялись ивы. Солнце поднималось все выше, туман редел, и скоро стало "
+    L"видно дальний лес и колокольню на холме. Дед сказал, что сегодня будет хороший "
+    L"улов, потому что ветер дует с юга, а вода спокойная и теплая. Внук поверил ему "
+    L"сразу, ведь старик редко ошибался в таких делах и помнил каждую примету.";
+
+// Модель, которой все кандидаты безразличны
+class flatModel : public ngramModel {
+public:
+    int order() const override { return 1; }
+    double score(const wchar_t*) const override { return 0; }
+};
+
+void test_search() {
+    print_section("ТЕСТЫ ПЕРЕБОРА ЧИСЛА СТОЛБЦОВ");
+    
+    // Расшифрование по вычисленным номерам совпадает с decrypt
+    assert_true([]() {
+        wstring original = L"ПРОГРАММИРОВАНИЕПЕНЗАСЪЕШЬЖЕЕЩЁЭТИХ";
+        for (int cols = 1; cols <= 40; cols++) {
+            routeCipher cipher(cols);
+            wstring encrypted = cipher.encrypt(original);
+            if (routeSearch(encrypted).candidateText(cols) != cipher.decrypt(encrypted)) {
+                return false;
+            }
+        }
+        return true;
+    }(), "candidateText совпадает с decrypt");
+    
+    // Верное число столбцов находится первым
+    assert_true([]() {
+        letterNgramModel model(corpus, 2);
+        for (int cols : {3, 7, 12, 25}) {
+            routeSearch search(routeCipher(cols).encrypt(corpus));
+            vector<routeCandidate> top = search.search(model, 60, 3);
+            if (top.size() != 3 || top[0].columns != cols || top[0].score < top[1].score) {
+                return false;
+            }
+        }
+        return true;
+    }(), "Биграммная модель находит число столбцов");
+    
+    // Триграммная модель и несколько потоков
+    assert_true([]() {
+        letterNgramModel model(corpus, 3);
+        routeSearch one(routeCipher(9).encrypt(corpus), 1);
+        routeSearch many(routeCipher(9).encrypt(corpus), 4);
+        vector<routeCandidate> a = one.search(model, 100, 5);
+        vector<routeCandidate> b = many.search(model, 100, 5);
+        for (size_t i = 0; i < a.size(); i++) {
+            if (a[i].columns != b[i].columns || a[i].score != b[i].score) {
+                return false;
+            }
+        }
+        return a[0].columns == 9;
+    }(), "Один и несколько потоков дают одинаковый результат");
+    
+    // Подключаемая модель: при равных баллах меньше столбцов - выше
+    assert_true([]() {
+        flatModel model;
+        vector<routeCandidate> top = routeSearch(L"АБВГДЕЖЗИК").search(model, 200, 4);
+        return top.size() == 4 && top[0].columns == 1 && top[3].columns == 4;
+    }(), "Пользовательская модель и ограничение по длине текста");
+    
+    // Больше 100 столбцов
+    assert_true([]() {
+        wstring text;
+        for (int i = 0; i < 5; i++) {
+            text += corpus;
+        }
+        routeSearch search(text);
+        return search.candidateText(150).size() == search.size()
+            && search.scoreColumns(150, letterNgramModel(corpus)) < 0;
+    }(), "Перебор не ограничен 100 столбцами");
+
+    // Буквы определяются по routeLocale(), как в routeCipher, а не по глобальной локали
+    assert_true([]() {
+        locale saved = locale::global(locale::classic());
+        routeSearch search(L"при вет, мир");
+        letterNgramModel model(L"привет мир", 2);
+        locale::global(saved);
+        return search.size() == 9 && search.candidateText(1) == L"ПРИВЕТМИР"
+            && model.score(L"ПР") > model.score(L"РП");
+    }(), "Перебор не зависит от глобальной локали");
+    
+    assert_exception([]() {
+        letterNgramModel model(corpus, 9);
+    }, "Неподдерживаемый порядок модели");
+    
+    assert_exception([]() {
+        routeSearch(L"").search(flatModel(), 10);
+    }, "Пустой шифротекст");
+}
+
+// ===================== ТЕСТЫ СЧЕТЧИКОВ ЭТАПОВ =====================
+void test_profile() {
+    print_section(profileEnabled ? "ТЕСТЫ СЧЕТЧИКОВ ЭТАПОВ (CIPHER_PROFILE)"
+                                 : "ТЕСТЫ СЧЕТЧИКОВ ЭТАПОВ (выключены)");
+    
+    // Счетчики заполняются только в сборке с CIPHER_PROFILE
+    assert_true([]() {
+        resetProfile();
+        routeCipher cipher(3);
+        wstring encrypted = cipher.encrypt(L"ПРИВЕТМИР");
+        cipher.decrypt(encrypted);
+        profileSnapshot p = takeProfile();
+        if (!profileEnabled) {
+            return p[profileStage::validate].calls == 0 && p[profileStage::output].calls == 0;
+        }
+        return p[profileStage::validate].calls == 2
+            && p[profileStage::validate].bytes == 18 * sizeof(wchar_t)
+            && p[profileStage::transform].calls == 2
+            && p[profileStage::output].calls == 2
+            && p[profileStage::output].allocations >= 2;
+    }(), "Счетчики этапов после encrypt/decrypt");
+
+    // Таблица - по вектору на строку, прототип строки и внешний вектор
+    assert_true([]() {
+        routeCipher cipher(3);
+        cipher.encrypt(L"ПРОГРЕВ"); // первый вызов создает локаль routeLocale()
+        resetProfile();
+        cipher.encrypt(L"ПРИВЕТМИРА"); // 4 строки
+        profileSnapshot p = takeProfile();
+        return p[profileStage::transform].allocations == (profileEnabled ? 4u + 2u : 0u)
+            && p[profileStage::output].allocations == (profileEnabled ? 1u : 0u);
+    }(), "Выделения памяти при построении таблицы");
+    
+    // Сброс
+    assert_true([]() {
+        routeCipher cipher(3);
+        cipher.encrypt(L"ТЕКСТ");
+        resetProfile();
+        profileSnapshot p = takeProfile();
+        for (const auto& s : p.stages) {
+            if (s.calls || s.nanoseconds || s.bytes || s.allocations) {
+                return false;
+            }
+        }
+        return true;
+    }(), "Сброс счетчиков");
+    
+    // Счетчики у каждого потока свои
+    assert_true([]() {
+        resetProfile();
+        uint64_t other = 0;
+        thread worker([&other]() {
+            routeCipher cipher(3);
+            cipher.encrypt(L"ТЕКСТ");
+            other = takeProfile()[profileStage::validate].calls;
+        });
+        worker.join();
+        return takeProfile()[profileStage::validate].calls == 0
+            && other == (profileEnabled ? 1u : 0u);
+    }(), "Счетчики раздельны по потокам");
+}
+
 // ===================== ГЛАВНАЯ ФУНКЦИЯ =====================
 int main() {
     // Настройка локали
@@ -331,6 +825,14 @@ int main() {
     test_decrypt();
     test_edge_cases();
     test_integration();
+    test_try_api();
+    test_preserving();
+    test_rounds();
+    test_arena();
+    test_batch();
+    test_fixed();
+    test_search();
+    test_profile();
     
     // Итоги
     cout << "\n" << string(70, '=') << endl;